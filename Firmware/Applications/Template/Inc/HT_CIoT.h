@@ -0,0 +1,111 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/*!
+ * \file HT_CIoT.h
+ * \brief Telemetry over the control-plane CIoT optimisation: readings are
+ *        batched in a compact binary frame and sent as NAS data on a
+ *        Non-IP PDN (+CSODCP), without IP, TCP, TLS or MQTT.
+ *
+ * \link https://github.com/htmicron
+ * \version 0.1
+ */
+
+#ifndef __HT_CIOT_H__
+#define __HT_CIOT_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "HT_Samples.h"
+
+/* Defines  ------------------------------------------------------------------*/
+
+#ifndef HT_CIOT_ENABLE
+#define HT_CIOT_ENABLE              0                   /**</ 1: telemetry over CIoT, the APN must be provisioned as Non-IP by the operator. 0: MQTT. */
+#endif
+
+#define HT_CIOT_CID                 0                   /**</ Context of the Non-IP PDN. */
+#define HT_CIOT_RAI                 2                   /**</ CMI_PS_RAI_ONLY_DL_FOLLOWED: release after the one downlink the report may get. */
+#define HT_CIOT_DOWNLINK_WAIT_MS    2000                /**</ Time left for that downlink before hibernating. */
+
+/*
+ * Uplink frame, big endian:
+ *   [0]    HT_CIOT_FRAME_READINGS
+ *   [1:2]  sequence number
+ *   [3]    reading count n
+ *   [4:5]  reporting interval in seconds, saturated
+ *   n x    [int16 temperature x10 C][uint16 humidity x10 %]
+ * A failed reading is HT_SAMPLES_TEMP_INVALID / HT_SAMPLES_HUM_INVALID.
+ *
+ * Downlink frame:
+ *   [0]    HT_CIOT_CMD_SET_INTERVAL
+ *   [1:4]  new reporting interval in seconds
+ */
+#define HT_CIOT_FRAME_READINGS      0x11                /**</ Version 1, readings. */
+#define HT_CIOT_CMD_SET_INTERVAL    0x21
+#define HT_CIOT_HEADER_LEN          6
+#define HT_CIOT_READING_LEN         4
+#define HT_CIOT_FRAME_MAX_LEN       (HT_CIOT_HEADER_LEN + HT_SAMPLES_MAX * HT_CIOT_READING_LEN)
+
+/* Functions ------------------------------------------------------------------*/
+
+/*!******************************************************************
+ * \fn bool HT_CIoT_SendBatch(void)
+ * \brief Sends the readings kept by HT_Samples.c in one frame over the
+ *        control plane, with HT_CIOT_RAI. The batch is cleared only on
+ *        success.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval true if the frame was handed to the modem.
+ *******************************************************************/
+bool HT_CIoT_SendBatch(void);
+
+/*!******************************************************************
+ * \fn void HT_CIoT_Downlink(const uint8_t *data, uint16_t len)
+ * \brief Takes a Non-IP downlink from the PS event callback. The command
+ *        is only decoded here; HT_CIoT_Process() applies it.
+ *
+ * \param[in]  data            Downlink payload.
+ * \param[in]  len             Payload length.
+ *
+ * \retval none
+ *******************************************************************/
+void HT_CIoT_Downlink(const uint8_t *data, uint16_t len);
+
+/*!******************************************************************
+ * \fn void HT_CIoT_Process(void)
+ * \brief Applies the command received by HT_CIoT_Downlink(), if any, from
+ *        the application task.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval none
+ *******************************************************************/
+void HT_CIoT_Process(void);
+
+#endif /* __HT_CIOT_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
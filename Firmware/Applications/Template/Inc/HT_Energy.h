@@ -0,0 +1,157 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/*!
+ * \file HT_Energy.h
+ * \brief Per-phase time and charge accounting of the wake cycle. Each
+ *        phase transition is timestamped, the durations are converted to
+ *        charge with a per-phase current model and the totals are kept in
+ *        the user NV memory across hibernations. A compact summary is
+ *        published when the scheduler health deadline is due.
+ *
+ * \link https://github.com/htmicron
+ * \version 0.1
+ */
+
+#ifndef __HT_ENERGY_H__
+#define __HT_ENERGY_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "MQTTClient.h"
+#include "HT_UsrNvMem.h"
+
+/* Defines  ------------------------------------------------------------------*/
+
+#define HT_ENERGY_SUMMARY_TOPIC     "hana/externo/senseclima/sensor03/energy"
+#define HT_ENERGY_AVG_SHIFT         3                   /**</ Weight 1/8 of the last wake in the moving average. */
+
+/*
+ * Current model: average module current in each phase, in uA. The radio
+ * phases average the TX bursts with the connected-mode reception between
+ * them; calibrate against a power analyser for the deployed band and
+ * coverage.
+ */
+#define HT_ENERGY_UA_BOOT           6000
+#define HT_ENERGY_UA_SIM            8000
+#define HT_ENERGY_UA_ATTACH         45000
+#define HT_ENERGY_UA_NET            40000
+#define HT_ENERGY_UA_TLS            35000               /**</ CPU-bound handshake steps between radio round trips. */
+#define HT_ENERGY_UA_MQTT           40000
+#define HT_ENERGY_UA_SUBSCRIBE      40000
+#define HT_ENERGY_UA_SENSE          4000                /**</ CPU and DHT22, radio idle. */
+#define HT_ENERGY_UA_PUBLISH        40000
+#define HT_ENERGY_UA_IDLE           12000               /**</ Connected, waiting for downlink or buttons. */
+#define HT_ENERGY_UA_SLEEP          10000               /**</ Detach or release and sleep entry. */
+#define HT_ENERGY_UA_HIBERNATE      4
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * \enum HT_EnergyPhase
+ * \brief Phases of a wake, in the order they normally happen.
+ */
+typedef enum {
+    HT_ENERGY_PHASE_BOOT = 0,                           /**</ Scheduler start until the application task runs. */
+    HT_ENERGY_PHASE_SIM,
+    HT_ENERGY_PHASE_ATTACH,                             /**</ Provisioning, attach and PDN activation. */
+    HT_ENERGY_PHASE_NET,                                /**</ Host resolution and TCP connect. */
+    HT_ENERGY_PHASE_TLS,
+    HT_ENERGY_PHASE_MQTT,                               /**</ MQTT CONNECT until CONNACK. */
+    HT_ENERGY_PHASE_SUBSCRIBE,
+    HT_ENERGY_PHASE_SENSE,
+    HT_ENERGY_PHASE_PUBLISH,
+    HT_ENERGY_PHASE_IDLE,                               /**</ Anything else while awake. */
+    HT_ENERGY_PHASE_SLEEP,                              /**</ Disconnect until the hibernation is armed. */
+    HT_ENERGY_PHASE_COUNT
+} HT_EnergyPhase;
+
+typedef char HT_EnergyPhase_SizeCheck[(HT_ENERGY_PHASE_COUNT <= HT_ENERGY_PHASE_MAX) ? 1 : -1];
+
+/* Functions ------------------------------------------------------------------*/
+
+/*!******************************************************************
+ * \fn void HT_Energy_Begin(void)
+ * \brief Starts the accounting of this wake: the time since the scheduler
+ *        started is charged to HT_ENERGY_PHASE_BOOT and
+ *        HT_ENERGY_PHASE_SIM begins.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval none
+ *******************************************************************/
+void HT_Energy_Begin(void);
+
+/*!******************************************************************
+ * \fn HT_EnergyPhase HT_Energy_Start(HT_EnergyPhase phase)
+ * \brief Closes the running phase and starts another one.
+ *
+ * \param[in]  phase           Phase starting now.
+ *
+ * \retval Phase that was running, so a nested step can restore it.
+ *******************************************************************/
+HT_EnergyPhase HT_Energy_Start(HT_EnergyPhase phase);
+
+/*!******************************************************************
+ * \fn void HT_Energy_Move(HT_EnergyPhase from, HT_EnergyPhase to, uint32_t ms)
+ * \brief Moves closed time between phases, for steps timed by another
+ *        module inside a single phase. At most the time already charged
+ *        to from is moved.
+ *
+ * \param[in]  from            Phase the time was charged to.
+ * \param[in]  to              Phase it belongs to.
+ * \param[in]  ms              Time to move.
+ *
+ * \retval none
+ *******************************************************************/
+void HT_Energy_Move(HT_EnergyPhase from, HT_EnergyPhase to, uint32_t ms);
+
+/*!******************************************************************
+ * \fn void HT_Energy_EndWake(uint32_t sleep_ms)
+ * \brief Closes the running phase, prints the wake breakdown and folds
+ *        it, with the hibernation about to start, into the statistics
+ *        kept in the user NV memory. Called once, right before sleeping.
+ *
+ * \param[in]  sleep_ms        Hibernation length.
+ *
+ * \retval none
+ *******************************************************************/
+void HT_Energy_EndWake(uint32_t sleep_ms);
+
+/*!******************************************************************
+ * \fn void HT_Energy_PublishSummary(MQTTClient *client)
+ * \brief Publishes the statistics with QoS 1 on HT_ENERGY_SUMMARY_TOPIC
+ *        when the HT_SCHEDULE_HEALTH deadline is due. The window restarts
+ *        only once the broker acknowledges the summary. Nothing is sent
+ *        before that or while disconnected.
+ *
+ * \param[in]  client          Connected MQTT client.
+ *
+ * \retval none
+ *******************************************************************/
+void HT_Energy_PublishSummary(MQTTClient *client);
+
+#endif /* __HT_ENERGY_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
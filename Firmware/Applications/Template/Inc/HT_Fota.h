@@ -0,0 +1,141 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/*!
+ * \file HT_Fota.h
+ * \brief Firmware update over the application's MQTT session.
+ *
+ * Protocol (all topics under HT_FOTA_TOPIC_BASE):
+ *  - manifest (broker -> device, retained): "<version> <size> <sha256 hex>"
+ *  - request  (device -> broker): "<version> <offset>", asks for the chunks
+ *             starting at offset; sent after connect and when the transfer stalls
+ *  - chunk    (broker -> device, QoS 1): 4 byte big endian offset followed by
+ *             HT_FOTA_CHUNK_LEN bytes of image, the last chunk padded to that size
+ *  - status   (device -> broker): "<version> <result>"
+ *
+ * Chunks are larger than the MQTT read buffer, so they reach the stream handler
+ * and go straight to FLASH_FOTA_REGION_START + offset. The highest contiguous
+ * offset lives in the user NV memory, so hibernation or a dropped connection
+ * resumes the download where it stopped.
+ *
+ *
+ * \link https://github.com/htmicron
+ * \version 0.1
+ */
+
+#ifndef __HT_FOTA_H__
+#define __HT_FOTA_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "MQTTClient.h"
+#include "mem_map.h"
+#include "HT_UsrNvMem.h"
+
+/* Defines  ------------------------------------------------------------------*/
+#define HT_FOTA_TOPIC_BASE          "hana/externo/senseclima/sensor03/fota"
+#define HT_FOTA_MANIFEST_TOPIC      HT_FOTA_TOPIC_BASE "/manifest"
+#define HT_FOTA_CHUNK_TOPIC         HT_FOTA_TOPIC_BASE "/chunk"
+#define HT_FOTA_REQUEST_TOPIC       HT_FOTA_TOPIC_BASE "/request"
+#define HT_FOTA_STATUS_TOPIC        HT_FOTA_TOPIC_BASE "/status"
+
+#define HT_FOTA_SECTOR_SIZE         0x1000                              /**</ Flash erase unit. */
+#define HT_FOTA_CHUNK_HDR_LEN       4                                   /**</ Big endian image offset. */
+#define HT_FOTA_CHUNK_LEN           HT_FOTA_SECTOR_SIZE                 /**</ Image bytes per chunk, one sector. */
+#define HT_FOTA_HANDOFF_ADDR        (FLASH_FOTA_REGION_END - HT_FOTA_SECTOR_SIZE) /**</ Sector holding HT_FotaHandoff_t. */
+#define HT_FOTA_MAX_IMAGE_SIZE      (FLASH_FOTA_REGION_LEN - HT_FOTA_SECTOR_SIZE)
+#define HT_FOTA_HANDOFF_MAGIC       0x41544F46                          /**</ "FOTA" */
+
+#define HT_FOTA_FLUSH_EVERY         16                                  /**</ Chunks between immediate NV flushes. */
+#define HT_FOTA_STALL_TIMEOUT_MS    30000                               /**</ Re-send the request after this long without a chunk. */
+#define HT_FOTA_AWAKE_BUDGET_MS     180000                              /**</ Longest a wake is extended for a download. */
+#define HT_FOTA_YIELD_MS            200                                 /**</ MQTTYield() slice per HT_FOTA_Process() call. */
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * \enum HT_FOTA_State
+ * \brief Download state kept in HT_FotaRetained_t.
+ */
+typedef enum {
+    HT_FOTA_IDLE = 0,
+    HT_FOTA_DOWNLOADING,
+    HT_FOTA_VERIFYING,
+    HT_FOTA_HANDOFF
+} HT_FOTA_State;
+
+/**
+ * \struct HT_FotaHandoff_t
+ * \brief Record written at HT_FOTA_HANDOFF_ADDR once the image is verified.
+ *        It tells the bootloader that FLASH_FOTA_REGION_START holds a
+ *        complete image of image_size bytes.
+ */
+typedef struct {
+    uint32_t magic;
+    uint32_t image_size;
+    uint8_t sha256[HT_FOTA_SHA256_LEN];
+    char version[HT_FOTA_VERSION_LEN];
+} HT_FotaHandoff_t;
+
+/* Functions ------------------------------------------------------------------*/
+
+/*!******************************************************************
+ * \fn void HT_FOTA_Init(MQTTClient *client)
+ * \brief Installs the chunk stream handler and subscribes to the FOTA
+ *        topics. Must be called after each MQTT connection.
+ *
+ * \param[in]  MQTTClient *client           Connected MQTT client.
+ * \param[out] none
+ *
+ * \retval none
+ *******************************************************************/
+void HT_FOTA_Init(MQTTClient *client);
+
+/*!******************************************************************
+ * \fn void HT_FOTA_Process(MQTTClient *client)
+ * \brief FSM hook. Sends pending requests, reads the socket while a
+ *        download is running and verifies and hands off a complete image.
+ *        Does not return once the image is handed off.
+ *
+ * \param[in]  MQTTClient *client           Connected MQTT client.
+ * \param[out] none
+ *
+ * \retval none
+ *******************************************************************/
+void HT_FOTA_Process(MQTTClient *client);
+
+/*!******************************************************************
+ * \fn bool HT_FOTA_IsBusy(void)
+ * \brief Tells whether a download should keep the device awake. Bounded
+ *        by HT_FOTA_AWAKE_BUDGET_MS per wake; the rest resumes later.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval true while downloading or verifying within the wake budget.
+ *******************************************************************/
+bool HT_FOTA_IsBusy(void);
+
+#endif /* __HT_FOTA_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -40,7 +40,6 @@
 #include "stdint.h"
 #include "main.h"
 #include "HT_MQTT_Api.h"
-#include "MQTTFreeRTOS.h"
 #include "bsp.h"
 // Movido HT_GPIO_Api.h para depois das definições de tipos
 #include "cmsis_os2.h"
@@ -127,6 +126,20 @@ HT_ConnectionStatus HT_FSM_MQTTConnect(void);
  *******************************************************************/
 void HT_FSM_SetSubscribeBuff(uint8_t *buff, uint8_t payload_len);
 
+/*!******************************************************************
+ * \fn void HT_FSM_SampleOnlyWake(void)
+ * \brief Wake that does not need the network: reads the DHT22 if the
+ *        sample deadline is due, keeps the reading for the next upload
+ *        and hibernates again without attaching or opening any
+ *        connection. Does not return.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval none
+ *******************************************************************/
+void HT_FSM_SampleOnlyWake(void);
+
 /*!******************************************************************
  * \fn void HT_Fsm(void)
  * \brief Finite State Machine of Push Button Example. Connect to
@@ -42,10 +42,43 @@
 #include "MQTTClient.h"
 #include "uart_qcx212.h"
 
+#ifndef MQTT_TLS_ENABLE
 #define MQTT_TLS_ENABLE 1
+#endif
+
+#ifndef HT_MQTT_RECV_TASK_ENABLE
+#define HT_MQTT_RECV_TASK_ENABLE 1                      /**</ Start the background receive task on plain TCP connections. */
+#endif
+
+#ifndef HT_MQTT_TLS_PSK_ENABLE
+#define HT_MQTT_TLS_PSK_ENABLE 1                        /**</ Use TLS-PSK when a PSK is provisioned (HT_TLS_Psk.h), certificates otherwise. */
+#endif
+
+#ifndef HT_MQTT_TLS_ZERO_COPY
+#define HT_MQTT_TLS_ZERO_COPY 1                         /**</ Serialize MQTT packets straight into the TLS output record; no MQTT send buffer is needed. */
+#endif
+
+#ifndef HT_MQTT_RAI_ENABLE
+#define HT_MQTT_RAI_ENABLE 1                            /**</ Send the last packet of a wake with RAI so the modem releases the RRC connection at once. */
+#endif
 
 #define MQTT_GENERAL_TIMEOUT 60000
 
+#define HT_MQTT_SUB_PAYLOAD_MAX_LEN 1024                /**</ Largest payload copied by the subscribe callback (MQTT RX buffer size). */
+#define HT_MQTT_SUB_TOPIC_MAX_LEN   128                 /**</ Largest topic name copied by the subscribe callback. */
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * \struct HT_MQTT_ConnectProfile
+ * \brief Time spent in each step of the last HT_MQTT_Connect() call.
+ */
+typedef struct {
+    uint32_t net_ms;                                    /**</ Host resolution and TCP connect. */
+    uint32_t tls_ms;                                    /**</ TLS setup and handshake, 0 without TLS. */
+    uint32_t mqtt_ms;                                   /**</ CONNECT sent until CONNACK. */
+} HT_MQTT_ConnectProfile;
+
 /* Functions ------------------------------------------------------------------*/
 
 /*!******************************************************************
@@ -64,7 +97,7 @@
  * \param[in] char *password                    Password to access MQTT topic.
  * \param[in] uint8_t mqtt_version              MQTT version.
  * \param[in] uint32_t keep_alive_interval      MQTT keep alive interval.
- * \param[in] uint32_t sendbuf                  Buffer allocated for TX process.
+ * \param[in] uint32_t sendbuf                  Buffer allocated for TX process, unused (may be NULL) with TLS and HT_MQTT_TLS_ZERO_COPY.
  * \param[in] uint32_t sendbuf_size             Size of TX buffer.
  * \param[in] uint32_t readbuf                  Buffer allocated for RX process.
  * \param[in] uint32_t readbuf_size             Size of RX buffer.
@@ -76,7 +109,19 @@ uint8_t HT_MQTT_Connect(MQTTClient *mqtt_client, Network *mqtt_network, char *ad
                                         uint32_t sendbuf_size, uint8_t *readbuf, uint32_t readbuf_size);
 
 /*!******************************************************************
- * \fn void HT_MQTT_Publish(MQTTClient *mqtt_client, char *topic, uint8_t *payload, uint32_t len, enum QoS qos, uint8_t retained, uint16_t id, uint8_t dup)
+ * \fn const HT_MQTT_ConnectProfile *HT_MQTT_GetConnectProfile(void)
+ * \brief Returns how long each step of the last HT_MQTT_Connect() call
+ *        took, failed calls included.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval Pointer to the static profile.
+ *******************************************************************/
+const HT_MQTT_ConnectProfile *HT_MQTT_GetConnectProfile(void);
+
+/*!******************************************************************
+ * \fn int HT_MQTT_Publish(MQTTClient *mqtt_client, char *topic, uint8_t *payload, uint32_t len, enum QoS qos, uint8_t retained, uint16_t id, uint8_t dup)
 
  * \brief Send an MQTT publish packet and wait for all acks, depending on the QoSs option.
  *
@@ -90,9 +135,9 @@ uint8_t HT_MQTT_Connect(MQTTClient *mqtt_client, Network *mqtt_network, char *ad
  * \param[in] uint8_t dup                       DUP flag.
  * 
  * 
- * \retval none
+ * \retval SUCCESS when sent and, with QoS 1 or 2, acknowledged; FAILURE or BUFFER_OVERFLOW otherwise.
  *******************************************************************/
-void HT_MQTT_Publish(MQTTClient *mqtt_client, char *topic, uint8_t *payload, uint32_t len, enum QoS qos, uint8_t retained, uint16_t id, uint8_t dup);
+int HT_MQTT_Publish(MQTTClient *mqtt_client, char *topic, uint8_t *payload, uint32_t len, enum QoS qos, uint8_t retained, uint16_t id, uint8_t dup);
 
 /*!******************************************************************
  * \fn void HT_MQTT_SubscribeCallback(MessageData *msg)
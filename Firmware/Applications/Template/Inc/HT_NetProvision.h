@@ -0,0 +1,98 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/*!
+ * \file HT_NetProvision.h
+ * \brief Network profile (band and APN) kept in a file of the little
+ *        filesystem and applied to the protocol stack only when the
+ *        stack configuration differs from it.
+ *
+ * \link https://github.com/htmicron
+ * \version 0.1
+ */
+
+#ifndef __HT_NETPROVISION_H__
+#define __HT_NETPROVISION_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+
+/* Defines  ------------------------------------------------------------------*/
+#define HT_PROV_FILE_NAME           "htnet.nvm"
+#define HT_PROV_MAGIC               0x54454E48          /**</ "HNET" */
+#define HT_PROV_MAX_BANDS           16                  /**</ Size of the orderBand array of appGetBandModeSync(). */
+#define HT_PROV_APN_MAX_LEN         100                 /**</ CMI_PS_MAX_APN_LEN */
+
+/*
+ * Factory profile: stored on the first boot that finds no profile file, and
+ * again whenever a firmware with different values is installed.
+ */
+#define HT_PROV_NETWORK_MODE        0                   /**</ NB-IoT */
+#define HT_PROV_BAND                28
+#define HT_PROV_CID                 0
+#define HT_PROV_APN                 "iot.datatem.com.br"
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * \struct HT_NetProfile_t
+ * \brief Desired network configuration.
+ */
+typedef struct {
+    uint8_t network_mode;
+    uint8_t band_num;                                   /**</ Valid entries of bands. */
+    uint8_t cid;
+    uint8_t pdn_type;                                   /**</ CmiPsPdnType */
+    uint8_t bands[HT_PROV_MAX_BANDS];                   /**</ Bands in priority order. */
+    char apn[HT_PROV_APN_MAX_LEN + 1];
+} HT_NetProfile_t;
+
+/* Functions ------------------------------------------------------------------*/
+
+/*!******************************************************************
+ * \fn bool HT_NetProvision_Apply(void)
+ * \brief Reads the band and APN configuration of the protocol stack and
+ *        writes only the parts that differ from the stored profile.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval true if the stack configuration was changed.
+ *******************************************************************/
+bool HT_NetProvision_Apply(void);
+
+/*!******************************************************************
+ * \fn bool HT_NetProvision_Store(const HT_NetProfile_t *profile)
+ * \brief Replaces the stored profile. It takes effect on the next
+ *        HT_NetProvision_Apply(). The file is left untouched when it
+ *        already holds the same profile.
+ *
+ * \param[in]  profile         New network profile.
+ *
+ * \retval true on success.
+ *******************************************************************/
+bool HT_NetProvision_Store(const HT_NetProfile_t *profile);
+
+#endif /* __HT_NETPROVISION_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,148 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/*!
+ * \file HT_Policy.h
+ * \brief Reporting policy: the battery voltage, the radio conditions and
+ *        the measured cost of a wake select an economy level, which
+ *        stretches the configured reporting interval and raises the
+ *        number of readings sent per upload.
+ *
+ * \link https://github.com/htmicron
+ * \version 0.1
+ */
+
+#ifndef __HT_POLICY_H__
+#define __HT_POLICY_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "HT_UsrNvMem.h"
+
+/* Defines  ------------------------------------------------------------------*/
+
+#define HT_POLICY_LEVEL_MAX         3                   /**</ Levels 0 (normal) to 3 (critical). */
+
+#define HT_POLICY_VBAT_GOOD_MV      3400                /**</ At or above: no battery penalty. */
+#define HT_POLICY_VBAT_LOW_MV       3200
+#define HT_POLICY_VBAT_CRITICAL_MV  3000
+#define HT_POLICY_VBAT_TIMEOUT_MS   100
+
+#define HT_POLICY_RSRP_WEAK_DBM     (-115)              /**</ Below: counted as CE level 1 at least. */
+#define HT_POLICY_SNR_WEAK_DB       (-3)
+#define HT_POLICY_WAKE_UC_HIGH      1500000             /**</ Averaged wake charge above which one level is added. */
+
+#define HT_POLICY_GATE_CE_LEVEL     2                   /**</ At or above: the upload waits for better coverage unless urgent. */
+#define HT_POLICY_GATE_RSRP_DBM     (-125)
+#define HT_POLICY_GATE_SNR_DB       (-8)
+#define HT_POLICY_GATE_MAX_AGE_MS   21600000            /**</ Age of the oldest kept reading past which the upload goes anyway. */
+
+#define HT_POLICY_MAX_INTERVAL_MS   86400000            /**</ Longest stretched reading interval; uploads span HT_POLICY_BATCH of them. */
+
+/* Interval multiplier and readings per upload of each level. */
+#define HT_POLICY_STRETCH           { 1, 2, 4, 8 }
+#define HT_POLICY_BATCH             { 1, 2, 4, 8 }
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * \struct HT_PolicyRadio_t
+ * \brief Radio conditions of the serving cell.
+ */
+typedef struct {
+    int16_t rsrp_dbm;
+    int8_t snr_db;
+    uint8_t ce_level;                                   /**</ Coverage enhancement level, 0 to 2. */
+} HT_PolicyRadio_t;
+
+/* Functions ------------------------------------------------------------------*/
+
+/*!******************************************************************
+ * \fn bool HT_Policy_SampleRadio(HT_PolicyRadio_t *radio)
+ * \brief Reads RSRP, SNR and the CE level from the protocol stack. Only
+ *        meaningful once attached.
+ *
+ * \param[out] radio           Radio conditions.
+ *
+ * \retval true if the stack answered with a measured cell.
+ *******************************************************************/
+bool HT_Policy_SampleRadio(HT_PolicyRadio_t *radio);
+
+/*!******************************************************************
+ * \fn void HT_Policy_Update(void)
+ * \brief Samples the battery and the radio, reads the averaged wake
+ *        charge from HT_Energy.c and selects the economy level, which is
+ *        kept in the user NV memory. A worse level applies at once, a
+ *        better one is approached a level per call. Called once per wake
+ *        after attach.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval none
+ *******************************************************************/
+void HT_Policy_Update(void);
+
+/*!******************************************************************
+ * \fn bool HT_Policy_DeferUpload(void)
+ * \brief Tells whether the upload of this wake should wait for better
+ *        coverage. It does when the radio read by HT_Policy_Update() in
+ *        this wake reaches HT_POLICY_GATE_CE_LEVEL or falls below the
+ *        RSRP or SNR gate, unless the upload is urgent: a wake not
+ *        caused by the timer, a batch this wake's reading would fill, or
+ *        a kept reading older than HT_POLICY_GATE_MAX_AGE_MS.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval true if the reading should only be kept.
+ *******************************************************************/
+bool HT_Policy_DeferUpload(void);
+
+/*!******************************************************************
+ * \fn uint32_t HT_Policy_SleepInterval(void)
+ * \brief Returns the configured reporting interval stretched for the
+ *        current level, capped at HT_POLICY_MAX_INTERVAL_MS.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval Interval in milliseconds.
+ *******************************************************************/
+uint32_t HT_Policy_SleepInterval(void);
+
+/*!******************************************************************
+ * \fn uint8_t HT_Policy_SamplesPerUpload(void)
+ * \brief Returns how many readings should be gathered before an upload
+ *        at the current level.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval Readings per upload, at least 1.
+ *******************************************************************/
+uint8_t HT_Policy_SamplesPerUpload(void);
+
+#endif /* __HT_POLICY_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
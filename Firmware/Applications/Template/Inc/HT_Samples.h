@@ -0,0 +1,127 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/*!
+ * \file HT_Samples.h
+ * \brief Sensor readings kept in the user NV memory across hibernation.
+ *        A wake that only has to sample stores its reading here and goes
+ *        back to sleep without the network; the next upload sends the
+ *        whole batch.
+ *
+ * \link https://github.com/htmicron
+ * \version 0.1
+ */
+
+#ifndef __HT_SAMPLES_H__
+#define __HT_SAMPLES_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "MQTTClient.h"
+#include "HT_UsrNvMem.h"
+
+/* Defines  ------------------------------------------------------------------*/
+
+#define HT_SAMPLES_BATCH_TOPIC      "hana/externo/senseclima/sensor03/batch"
+#define HT_SAMPLES_UPLOAD_MIN       1                   /**</ Least readings per upload; HT_Policy_SamplesPerUpload() may ask for more, up to HT_SAMPLES_MAX. */
+
+#define HT_SAMPLES_TEMP_INVALID     ((int16_t)0x7FFF)
+#define HT_SAMPLES_HUM_INVALID      ((uint16_t)0xFFFF)
+
+/* Functions ------------------------------------------------------------------*/
+
+/*!******************************************************************
+ * \fn void HT_Samples_Add(bool valid, float temperature, float humidity)
+ * \brief Appends a reading, in tenths, to the retained batch. A failed
+ *        reading is kept as HT_SAMPLES_TEMP_INVALID / HT_SAMPLES_HUM_INVALID.
+ *        When the batch is full the oldest reading is dropped.
+ *
+ * \param[in]  valid           The sensor returned a reading.
+ * \param[in]  temperature     Temperature in degrees Celsius.
+ * \param[in]  humidity        Relative humidity in percent.
+ *
+ * \retval none
+ *******************************************************************/
+void HT_Samples_Add(bool valid, float temperature, float humidity);
+
+/*!******************************************************************
+ * \fn uint8_t HT_Samples_Count(void)
+ * \brief Returns how many readings are waiting for an upload.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval Readings in the retained batch.
+ *******************************************************************/
+uint8_t HT_Samples_Count(void);
+
+/*!******************************************************************
+ * \fn uint8_t HT_Samples_PerUpload(void)
+ * \brief Returns the batch size of an upload: HT_SAMPLES_UPLOAD_MIN or
+ *        the reporting policy batch, whichever is larger.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval Readings per upload, from 1 to HT_SAMPLES_MAX.
+ *******************************************************************/
+uint8_t HT_Samples_PerUpload(void);
+
+/*!******************************************************************
+ * \fn const HT_SamplesRetained_t *HT_Samples_Get(void)
+ * \brief Returns the retained batch, oldest reading first.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval Pointer to the batch, NULL without user NV memory.
+ *******************************************************************/
+const HT_SamplesRetained_t *HT_Samples_Get(void);
+
+/*!******************************************************************
+ * \fn void HT_Samples_Uploaded(void)
+ * \brief Clears the batch after a successful upload and advances the
+ *        sequence number.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval none
+ *******************************************************************/
+void HT_Samples_Uploaded(void);
+
+/*!******************************************************************
+ * \fn bool HT_Samples_Publish(MQTTClient *client)
+ * \brief Publishes the waiting readings in one QoS 1 JSON message on
+ *        HT_SAMPLES_BATCH_TOPIC. The batch is cleared only once the
+ *        broker acknowledges it; otherwise it waits for the next upload.
+ *
+ * \param[in]  client          Connected MQTT client.
+ *
+ * \retval true when no reading is left waiting.
+ *******************************************************************/
+bool HT_Samples_Publish(MQTTClient *client);
+
+#endif /* __HT_SAMPLES_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,142 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/*!
+ * \file HT_Schedule.h
+ * \brief Wake scheduler. Each periodic task owns one of the deep sleep
+ *        timers 0-6, which count across hibernation for up to 580 hours,
+ *        so a long deadline keeps running while shorter ones wake the
+ *        device. The PMU wakes on the earliest timer; at boot the timers
+ *        that are no longer running tell which tasks are due.
+ *
+ * \link https://github.com/htmicron
+ * \version 0.1
+ */
+
+#ifndef __HT_SCHEDULE_H__
+#define __HT_SCHEDULE_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "slpman_qcx212.h"
+#include "HT_UsrNvMem.h"
+
+/* Defines  ------------------------------------------------------------------*/
+
+#define HT_SCHEDULE_HEALTH_PERIOD_MS    86400000        /**</ Energy summary and a forced network wake, once a day. */
+#define HT_SCHEDULE_MAX_PERIOD_MS       DEEPSLP_TIMER_MAXRANGE  /**</ 580 hours, in ms. */
+#define HT_SCHEDULE_MIN_REMAIN_MS       1000            /**</ Deadline left when a new period has already elapsed. */
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * \enum HT_ScheduleTask
+ * \brief Periodic tasks. Task n runs on DEEPSLP_TIMER_ID0 + n.
+ */
+typedef enum {
+    HT_SCHEDULE_SAMPLE = 0,                             /**</ DHT22 reading, every HT_Policy_SleepInterval(). */
+    HT_SCHEDULE_UPLOAD,                                 /**</ Batch upload, every HT_Samples_PerUpload() readings. */
+    HT_SCHEDULE_HEALTH,                                 /**</ Energy summary, every HT_SCHEDULE_HEALTH_PERIOD_MS. */
+    HT_SCHEDULE_COUNT
+} HT_ScheduleTask;
+
+typedef char HT_Schedule_SizeCheck[(HT_SCHEDULE_COUNT <= HT_SCHEDULE_TASK_MAX) ? 1 : -1];
+
+/* Functions ------------------------------------------------------------------*/
+
+/*!******************************************************************
+ * \fn void HT_Schedule_Begin(void)
+ * \brief Finds the tasks due in this wake: those whose timer expired,
+ *        and all of them after power on or when none was armed yet.
+ *        Must run before anything restarts the timers.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval none
+ *******************************************************************/
+void HT_Schedule_Begin(void);
+
+/*!******************************************************************
+ * \fn bool HT_Schedule_IsDue(HT_ScheduleTask task)
+ * \brief Tells whether the task deadline expired before this wake.
+ *
+ * \param[in]  task            Task to check.
+ *
+ * \retval true if the task is due.
+ *******************************************************************/
+bool HT_Schedule_IsDue(HT_ScheduleTask task);
+
+/*!******************************************************************
+ * \fn bool HT_Schedule_NeedsNetwork(void)
+ * \brief Tells whether this wake has to reach the network: an upload or
+ *        health deadline expired, or the due reading completes the
+ *        upload batch.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval true if the wake cannot be served offline.
+ *******************************************************************/
+bool HT_Schedule_NeedsNetwork(void);
+
+/*!******************************************************************
+ * \fn void HT_Schedule_Done(HT_ScheduleTask task)
+ * \brief Records that the task ran in this wake, so its deadline
+ *        restarts from now when the device goes to sleep, even if its
+ *        timer was still running.
+ *
+ * \param[in]  task            Task that ran.
+ *
+ * \retval none
+ *******************************************************************/
+void HT_Schedule_Done(HT_ScheduleTask task);
+
+/*!******************************************************************
+ * \fn uint32_t HT_Schedule_Period(HT_ScheduleTask task)
+ * \brief Returns the current period of a task, from the configured
+ *        interval and the reporting policy.
+ *
+ * \param[in]  task            Task to check.
+ *
+ * \retval Period in milliseconds, at most HT_SCHEDULE_MAX_PERIOD_MS.
+ *******************************************************************/
+uint32_t HT_Schedule_Period(HT_ScheduleTask task);
+
+/*!******************************************************************
+ * \fn uint32_t HT_Schedule_Arm(void)
+ * \brief Starts the timers of the tasks that ran or expired, and keeps
+ *        the rest running. A task whose period changed since its timer
+ *        was started gets the new period counted from that start.
+ *        Called right before hibernation.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval Time until the earliest deadline, in milliseconds.
+ *******************************************************************/
+uint32_t HT_Schedule_Arm(void);
+
+#endif /* __HT_SCHEDULE_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
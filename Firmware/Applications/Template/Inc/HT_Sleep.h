@@ -41,23 +41,122 @@
 #include "slpman_qcx212.h"
 #include "pmu_qcx212.h"
 
-// Timer ID para o deep sleep
-#define DEEPSLP_TIMER_ID7 7
+#define HT_SLEEP_USE_PSM                1       /**</ 1: hibernate in PSM keeping the PDN context, 0: detach with CFUN=0. */
+#define HT_SLEEP_PSM_ACTIVE_TIME_S      10      /**</ Requested T3324: paging window after the last transfer. */
+#define HT_SLEEP_PSM_TAU_MARGIN_S       600     /**</ Requested T3412 exceeds the upload period by this much. */
+
+#define HT_SLEEP_ENTRY_MARGIN_MS        15000   /**</ Time for the PMU to hibernate after CFUN=0, or after T3324 in PSM. */
+#define HT_SLEEP_FALLBACK_MS            5000    /**</ Time for the PMU to hibernate once the fallback released everything. */
+#define HT_SLEEP_MAX_HOLDS              4       /**</ Application vote handles tracked by HT_Sleep_Hold(). */
+
+/*!******************************************************************
+ * \fn void HT_Sleep_ConfigurePsm(uint32_t interval_ms)
+ * \brief Requests PSM with a periodic TAU (T3412) longer than the
+ *        upload period, so the upload wake comes before the TAU,
+ *        and a short active time (T3324). The request is only sent when
+ *        it differs from the one kept in the user NV memory. With
+ *        HT_SLEEP_USE_PSM set to 0, PSM is disabled instead.
+ *
+ * \param[in]  interval_ms   Upload period in milliseconds.
+ *
+ * \retval none
+ *******************************************************************/
+void HT_Sleep_ConfigurePsm(uint32_t interval_ms);
+
+/*!******************************************************************
+ * \fn bool HT_Sleep_PsmResumed(void)
+ * \brief Tells whether this boot is a wake from a hibernation that kept
+ *        the registration, in which case the band/APN setup and the
+ *        attach wait must be skipped.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval true if the PDN context was kept across the hibernation.
+ *******************************************************************/
+bool HT_Sleep_PsmResumed(void);
+
+/*!******************************************************************
+ * \fn uint8_t HT_Sleep_Hold(const char *name, slpManSlpState_t state)
+ * \brief Votes against sleep with a named platform vote handle and keeps
+ *        track of it, so HT_Sleep_EnterSleep() can release it and name
+ *        it when sleep is blocked.
+ *
+ * \param[in]  name          Handle name, up to 8 characters.
+ * \param[in]  state         Sleep state the vote applies to.
+ *
+ * \retval Vote handle, 0xFF if none is available.
+ *******************************************************************/
+uint8_t HT_Sleep_Hold(const char *name, slpManSlpState_t state);
 
 /*!******************************************************************
- * \fn void HT_Sleep_EnterSleep(slpManSlpState_t state, uint32_t sleep_ms)
- * \brief Enters a specified sleep state for a certain duration.
+ * \fn void HT_Sleep_Release(uint8_t handle)
+ * \brief Withdraws the vote taken by HT_Sleep_Hold().
  *
- * This function configures the AON timer as a wakeup source and
- * then enters the specified sleep mode. Execution resumes after
- * the timer expires.
+ * \param[in]  handle        Handle returned by HT_Sleep_Hold().
+ *
+ * \retval none
+ *******************************************************************/
+void HT_Sleep_Release(uint8_t handle);
+
+/*!******************************************************************
+ * \fn void HT_Sleep_StackEvent(uint16_t event_id)
+ * \brief Reports a protocol stack event from the PS callback. While a
+ *        hibernation is pending it wakes the sleep wait, which logs the
+ *        event and keeps it for the deadline diagnostic.
+ *
+ * \param[in]  event_id      urcID_t of the event.
+ *
+ * \retval none
+ *******************************************************************/
+void HT_Sleep_StackEvent(uint16_t event_id);
+
+/*!******************************************************************
+ * \fn void HT_Sleep_ReportLastEntry(void)
+ * \brief Prints, once, the diagnostic kept by the last hibernation entry
+ *        that missed its deadline.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval none
+ *******************************************************************/
+void HT_Sleep_ReportLastEntry(void);
+
+/*!******************************************************************
+ * \fn void HT_Sleep_EnterSleep(slpManSlpState_t state)
+ * \brief Enters a specified sleep state until the next deadline.
+ *
+ * The deep sleep timers of the scheduler (HT_Schedule_Arm()) are the
+ * wakeup sources, so execution resumes at the earliest task deadline.
+ * When the network granted PSM the registration is kept, otherwise
+ * the radio is detached with CFUN=0.
+ *
+ * The votes taken with HT_Sleep_Hold() are released and the PMU is
+ * given HT_SLEEP_ENTRY_MARGIN_MS (past T3324 in PSM) to hibernate.
+ * Past that deadline the blocking votes and driver activity are
+ * printed, the radio is detached and every tracked vote is forced to
+ * allow sleep. If the PMU still does not hibernate within
+ * HT_SLEEP_FALLBACK_MS the diagnostic is saved and the device resets.
+ *
+ * \param[in]  state      The sleep state to enter (e.g., SLP_SLP1_STATE).
+ *
+ * \retval none
+ *******************************************************************/
+void HT_Sleep_EnterSleep(slpManSlpState_t state);
+
+/*!******************************************************************
+ * \fn void HT_Sleep_EnterSleepOffline(slpManSlpState_t state)
+ * \brief Same as HT_Sleep_EnterSleep() for a wake that did not use the
+ *        network. The PSM request is not renewed: a registration kept
+ *        by the last hibernation stays in PSM, otherwise the attach the
+ *        stack started at boot is cut short with CFUN=0.
  *
  * \param[in]  state      The sleep state to enter (e.g., SLP_SLP1_STATE).
- * \param[in]  sleep_ms   Duration to sleep in milliseconds.
  *
  * \retval none
  *******************************************************************/
-void HT_Sleep_EnterSleep(slpManSlpState_t state, uint32_t sleep_ms);
+void HT_Sleep_EnterSleepOffline(slpManSlpState_t state);
 
 #endif /*__HT_SLEEP_H__*/
 
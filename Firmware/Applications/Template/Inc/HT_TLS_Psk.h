@@ -0,0 +1,96 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/*!
+ * \file HT_TLS_Psk.h
+ * \brief Per-device TLS-PSK identity and key kept in a file of the
+ *        little filesystem, so they survive firmware updates and changes
+ *        of the user NV memory layout.
+ *
+ * \link https://github.com/htmicron
+ * \version 0.1
+ */
+
+#ifndef __HT_TLS_PSK_H__
+#define __HT_TLS_PSK_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "stddef.h"
+
+/* Defines  ------------------------------------------------------------------*/
+#define HT_PSK_FILE_NAME            "htpsk.nvm"
+#define HT_PSK_MAGIC                0x4B535048          /**</ "HPSK" */
+#define HT_PSK_IDENTITY_MAX_LEN     64
+#define HT_PSK_KEY_MAX_LEN          32                  /**</ MBEDTLS_PSK_MAX_LEN of the bundled library. */
+
+/*
+ * Factory provisioning: building with
+ *   -DHT_PSK_FACTORY_IDENTITY=\"sensor03\" -DHT_PSK_FACTORY_KEY_HEX=\"00112233...\"
+ * writes these credentials on the first boot that finds no PSK file.
+ */
+
+/* Functions ------------------------------------------------------------------*/
+
+/*!******************************************************************
+ * \fn bool HT_PSK_Load(const uint8_t **identity, size_t *identity_len, const uint8_t **key, size_t *key_len)
+ * \brief Returns the provisioned PSK. The file is read once per boot;
+ *        later calls return the cached copy.
+ *
+ * \param[out] identity        PSK identity.
+ * \param[out] identity_len    PSK identity length.
+ * \param[out] key             PSK.
+ * \param[out] key_len         PSK length.
+ *
+ * \retval true if a valid PSK is provisioned.
+ *******************************************************************/
+bool HT_PSK_Load(const uint8_t **identity, size_t *identity_len, const uint8_t **key, size_t *key_len);
+
+/*!******************************************************************
+ * \fn bool HT_PSK_Provision(const uint8_t *identity, size_t identity_len, const uint8_t *key, size_t key_len)
+ * \brief Stores a new PSK. The file is left untouched when it already
+ *        holds the same credentials.
+ *
+ * \param[in]  identity        PSK identity.
+ * \param[in]  identity_len    PSK identity length, up to HT_PSK_IDENTITY_MAX_LEN.
+ * \param[in]  key             PSK.
+ * \param[in]  key_len         PSK length, up to HT_PSK_KEY_MAX_LEN.
+ *
+ * \retval true on success.
+ *******************************************************************/
+bool HT_PSK_Provision(const uint8_t *identity, size_t identity_len, const uint8_t *key, size_t key_len);
+
+/*!******************************************************************
+ * \fn void HT_PSK_Erase(void)
+ * \brief Removes the PSK; the next connections use certificates.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval none
+ *******************************************************************/
+void HT_PSK_Erase(void);
+
+#endif /* __HT_TLS_PSK_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
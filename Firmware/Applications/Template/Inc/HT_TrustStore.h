@@ -0,0 +1,148 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/*!
+ * \file HT_TrustStore.h
+ * \brief TLS certificates, client key and server pins kept as DER in a
+ *        dedicated flash area (FLASH_TRUST_STORE_START). The TLS layer parses
+ *        them in place through the XIP mapping, with no base64 decoding and
+ *        no copy of the certificate data.
+ *
+ * Layout: HT_TrustStoreHeader_t at the start of the area, the items after it.
+ * The header is written last, so an interrupted provisioning leaves no valid
+ * store behind.
+ *
+ * Provisioning: Debug/Scripts/trust_store.py builds the image of the area
+ * from PEM or DER files and server certificates to pin; the flash tool
+ * writes it at FLASH_TRUST_STORE_START with the application. The area is
+ * outside the application image, so later firmware updates keep it.
+ * HT_TrustStore_Provision() writes the same layout from the firmware.
+ *
+ *
+ * \link https://github.com/htmicron
+ * \version 0.1
+ */
+
+#ifndef __HT_TRUSTSTORE_H__
+#define __HT_TRUSTSTORE_H__
+
+#include "stdint.h"
+#include "stdbool.h"
+#include "stddef.h"
+#include "mem_map.h"
+
+/* Defines  ------------------------------------------------------------------*/
+#define HT_TRUST_STORE_MAGIC        0x53545448          /**</ "HTTS" */
+#define HT_TRUST_STORE_VERSION      1
+#define HT_TRUST_STORE_MAX_ITEMS    4                   /**</ One item per HT_TrustType. */
+#define HT_TRUST_STORE_SECTOR_SIZE  0x1000
+#define HT_TRUST_STORE_XIP_ADDR     (FLASH_XIP_ADDR + FLASH_TRUST_STORE_START)
+#define HT_TRUST_PIN_LEN            32                  /**</ SHA-256 of the server SubjectPublicKeyInfo. */
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * \enum HT_TrustType
+ * \brief Kind of a trust store item.
+ */
+typedef enum {
+    HT_TRUST_CA_CERT = 1,                               /**</ One or more concatenated DER certificates. */
+    HT_TRUST_CLIENT_CERT,                               /**</ DER certificate. */
+    HT_TRUST_CLIENT_KEY,                                /**</ DER private key (PKCS#1, SEC1 or PKCS#8, unencrypted). */
+    HT_TRUST_SERVER_PINS                                /**</ Concatenated HT_TRUST_PIN_LEN byte hashes. */
+} HT_TrustType;
+
+/**
+ * \struct HT_TrustEntry_t
+ * \brief Item location, relative to FLASH_TRUST_STORE_START.
+ */
+typedef struct {
+    uint32_t type;
+    uint32_t offset;
+    uint32_t len;
+} HT_TrustEntry_t;
+
+/**
+ * \struct HT_TrustStoreHeader_t
+ * \brief First bytes of the trust store area.
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t count;
+    HT_TrustEntry_t entry[HT_TRUST_STORE_MAX_ITEMS];
+    uint8_t sha256[32];                                 /**</ SHA-256 of entry[] followed by the SHA-256 of the items. */
+} HT_TrustStoreHeader_t;
+
+/**
+ * \struct HT_TrustItem_t
+ * \brief Item handed to HT_TrustStore_Provision().
+ */
+typedef struct {
+    HT_TrustType type;
+    const uint8_t *data;                                /**</ DER, or PEM text converted to DER while it is written. */
+    size_t len;
+} HT_TrustItem_t;
+
+/* Functions ------------------------------------------------------------------*/
+
+/*!******************************************************************
+ * \fn bool HT_TrustStore_Get(HT_TrustType type, const uint8_t **data, size_t *len)
+ * \brief Returns an item of the trust store as a pointer into the XIP
+ *        mapped flash. The store is checked once per boot.
+ *
+ * \param[in]  type            Item to look up.
+ * \param[out] data            Item data, valid until the store is provisioned again.
+ * \param[out] len             Item length.
+ *
+ * \retval true if the store is valid and holds the item.
+ *******************************************************************/
+bool HT_TrustStore_Get(HT_TrustType type, const uint8_t **data, size_t *len);
+
+/*!******************************************************************
+ * \fn bool HT_TrustStore_Provision(const HT_TrustItem_t *items, uint8_t count)
+ * \brief Replaces the trust store. PEM items are decoded line by line
+ *        into flash, so no buffer of the item size is needed. The flash
+ *        is left untouched when it already holds the same items.
+ *
+ * \param[in]  items           Items to store, one per HT_TrustType at most.
+ * \param[in]  count           Number of items, up to HT_TRUST_STORE_MAX_ITEMS.
+ *
+ * \retval true on success.
+ *******************************************************************/
+bool HT_TrustStore_Provision(const HT_TrustItem_t *items, uint8_t count);
+
+/*!******************************************************************
+ * \fn void HT_TrustStore_Erase(void)
+ * \brief Invalidates the trust store.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval none
+ *******************************************************************/
+void HT_TrustStore_Erase(void);
+
+#endif /* __HT_TRUSTSTORE_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,226 @@
+/*
+
+  _    _ _______   __  __ _____ _____ _____   ____  _   _
+ | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+ | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+ |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+ | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+ |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+ =================== Advanced R&D ========================
+
+ Copyright (c) 2023 HT Micron Semicondutores S.A.
+ Licensed under the Apache License, Version 2.0 (the "License");
+ you may not use this file except in compliance with the License.
+ You may obtain a copy of the License at
+ http://www.apache.org/licenses/LICENSE-2.0
+ Unless required by applicable law or agreed to in writing, software
+ distributed under the License is distributed on an "AS IS" BASIS,
+ WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ See the License for the specific language governing permissions and
+ limitations under the License.
+
+*/
+
+/*!
+ * \file HT_UsrNvMem.h
+ * \brief Layout of the user NV memory (slpManGetUsrNVMem) shared by the
+ *        application modules. The SDK restores this area after sleep2,
+ *        hibernate and power on.
+ *
+ * \link https://github.com/htmicron
+ * \version 0.1
+ */
+
+#ifndef __HT_USRNVMEM_H__
+#define __HT_USRNVMEM_H__
+
+#include "stdint.h"
+#include "time.h"
+
+/* Defines  ------------------------------------------------------------------*/
+#define HT_USRNVMEM_MAGIC       0x48544E56              /**</ "HTNV": the area holds this layout. */
+#define HT_USRNVMEM_VERSION     2                       /**</ Bumped only when existing fields move. */
+#define HT_USRNVMEM_MAX_SIZE    2016                    /**</ Size of the user NV memory given by slpman. */
+
+#define HT_FOTA_VERSION_LEN     16                      /**</ Firmware version string, null terminated. */
+#define HT_FOTA_SHA256_LEN      32                      /**</ SHA-256 digest length. */
+
+#define HT_TLS_SESSION_MAX_LEN  512                     /**</ Serialized mbedtls_ssl_session, ticket included. */
+
+#define HT_SAMPLES_MAX          12                      /**</ Readings kept across hibernation until an upload. */
+
+#define HT_ENERGY_PHASE_MAX     12                      /**</ Wake phases accounted by HT_Energy.c. */
+
+#define HT_SCHEDULE_TASK_MAX    4                       /**</ Periodic tasks of HT_Schedule.c. */
+
+/* Typedefs  ------------------------------------------------------------------*/
+
+/**
+ * \struct HT_FotaRetained_t
+ * \brief Download progress kept across hibernation by HT_Fota.c.
+ */
+typedef struct {
+    uint32_t state;                                     /**</ HT_FOTA_State. */
+    uint32_t image_size;                                /**</ Image size announced by the manifest. */
+    uint32_t contiguous;                                /**</ Bytes written without holes from the region start. */
+    uint8_t sha256[HT_FOTA_SHA256_LEN];                 /**</ Expected image digest. */
+    char version[HT_FOTA_VERSION_LEN];                  /**</ Version being downloaded or last handed off. */
+} HT_FotaRetained_t;
+
+/**
+ * \struct HT_TlsSessionRetained_t
+ * \brief Last TLS session, offered for resumption on the next connect.
+ */
+typedef struct {
+    uint16_t len;                                       /**</ Serialized length, 0 when empty. */
+    uint16_t port;                                      /**</ Broker the session belongs to. */
+    uint32_t host_hash;
+    uint8_t data[HT_TLS_SESSION_MAX_LEN];
+} HT_TlsSessionRetained_t;
+
+/**
+ * \struct HT_PsmRetained_t
+ * \brief PSM timers requested by HT_Sleep.c and whether the last
+ *        hibernation kept the network registration.
+ */
+typedef struct {
+    uint32_t req_tau_s;                                 /**</ Requested T3412, 0 when PSM was not requested. */
+    uint32_t req_active_s;                              /**</ Requested T3324. */
+    uint8_t registered;                                 /**</ Hibernated in PSM, the PDN context is still up. */
+    uint8_t rsvd[3];
+} HT_PsmRetained_t;
+
+/**
+ * \struct HT_SamplesRetained_t
+ * \brief Readings kept by HT_Samples.c until the next upload, oldest
+ *        first, over MQTT or in a control-plane frame.
+ */
+typedef struct {
+    uint16_t seq;                                       /**</ Sequence number of the next upload. */
+    uint8_t count;
+    uint8_t rsvd;
+    int16_t temp_x10[HT_SAMPLES_MAX];
+    uint16_t hum_x10[HT_SAMPLES_MAX];
+} HT_SamplesRetained_t;
+
+/**
+ * \struct HT_EnergyRetained_t
+ * \brief Wake cycle statistics accumulated by HT_Energy.c. The window
+ *        fields restart every time a summary is published.
+ */
+typedef struct {
+    uint32_t wakes;                                     /**</ Wakes in the window. */
+    uint32_t phase_ms[HT_ENERGY_PHASE_MAX];             /**</ Time per phase in the window. */
+    uint32_t awake_uc;                                  /**</ Estimated awake charge in the window, uC. */
+    uint32_t sleep_s;                                   /**</ Hibernation requested in the window. */
+    uint32_t sleep_uc;                                  /**</ Estimated hibernation charge in the window, uC. */
+    uint32_t last_wake_uc;                              /**</ Charge of the last wake. */
+    uint32_t avg_wake_uc;                               /**</ Moving average of the wake charge. */
+    uint32_t total_mc;                                  /**</ Estimated charge since the memory was cleared, mC. */
+    uint16_t seq;                                       /**</ Sequence number of the next summary. */
+    uint16_t rsvd;
+} HT_EnergyRetained_t;
+
+/**
+ * \struct HT_PolicyRetained_t
+ * \brief Last inputs and decision of the reporting policy (HT_Policy.c).
+ */
+typedef struct {
+    uint16_t vbat_mv;                                   /**</ Last battery reading, 0 when unknown. */
+    int16_t rsrp_dbm;
+    int8_t snr_db;
+    uint8_t ce_level;
+    uint8_t radio_valid;                                /**</ rsrp_dbm, snr_db and ce_level were read. */
+    uint8_t level;                                      /**</ Economy level in use. */
+} HT_PolicyRetained_t;
+
+/**
+ * \struct HT_SleepRetained_t
+ * \brief Last hibernation entry that missed its deadline, recorded by
+ *        HT_Sleep.c for the next boot.
+ */
+typedef struct {
+    uint16_t entry_failures;                            /**</ Entries that missed the deadline. */
+    uint8_t last_stage;                                 /**</ 0: none pending, 1: fallback slept, 2: fallback reset. */
+    uint8_t last_pmu_state;                             /**</ slpManPlatGetSlpState() at the deadline. */
+    uint32_t last_hib_bitmap;                           /**</ Platform votes against hibernate. */
+    uint32_t last_drv_bitmap;                           /**</ Driver votes against sleep, mask applied. */
+    uint16_t last_event_id;                             /**</ Last protocol stack event seen while waiting. */
+    uint16_t rsvd;
+} HT_SleepRetained_t;
+
+/**
+ * \struct HT_ScheduleRetained_t
+ * \brief Deep sleep timers armed by HT_Schedule.c. The timers count in
+ *        the PMU; this only tells which ones were started.
+ */
+typedef struct {
+    uint8_t armed;                                      /**</ Bit n: timer of task n was started. */
+    uint8_t rsvd[3];
+    uint32_t period_ms[HT_SCHEDULE_TASK_MAX];           /**</ Period the running deadline of each task counts against. */
+} HT_ScheduleRetained_t;
+
+/**
+ * \struct HT_UsrNvMem_t
+ * \brief User NV memory layout. New sections are appended at the end so an
+ *        older image's data stays valid; the new tail starts zeroed.
+ */
+typedef struct {
+    uint32_t magic;
+    uint16_t version;
+    uint16_t size;                                      /**</ sizeof(HT_UsrNvMem_t) of the image that wrote it. */
+    time_t sleep_start_time;                            /**</ Set before hibernation, printed after wakeup. */
+    HT_FotaRetained_t fota;
+    HT_TlsSessionRetained_t tls_session;
+    HT_PsmRetained_t psm;
+    HT_SamplesRetained_t samples;
+    HT_EnergyRetained_t energy;
+    HT_PolicyRetained_t policy;
+    HT_SleepRetained_t sleep;
+    HT_ScheduleRetained_t schedule;
+} HT_UsrNvMem_t;
+
+typedef char HT_UsrNvMem_SizeCheck[(sizeof(HT_UsrNvMem_t) <= HT_USRNVMEM_MAX_SIZE) ? 1 : -1];
+
+/* Functions ------------------------------------------------------------------*/
+
+/*!******************************************************************
+ * \fn HT_UsrNvMem_t *HT_UsrNvMem_Get(void)
+ * \brief Returns the user NV memory. The first call validates the header:
+ *        a foreign or older-version layout is cleared, a shorter layout
+ *        of the same version gets its new tail zeroed.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval Pointer to the retained data, NULL if slpman has none.
+ *******************************************************************/
+HT_UsrNvMem_t *HT_UsrNvMem_Get(void);
+
+/*!******************************************************************
+ * \fn void HT_UsrNvMem_Update(void)
+ * \brief Marks the user NV memory dirty. It is written to flash right
+ *        before sleep2 or hibernate.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval none
+ *******************************************************************/
+void HT_UsrNvMem_Update(void);
+
+/*!******************************************************************
+ * \fn void HT_UsrNvMem_Flush(void)
+ * \brief Writes the user NV memory to flash immediately, for data that
+ *        has to survive a reset and not only a sleep.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval none
+ *******************************************************************/
+void HT_UsrNvMem_Flush(void);
+
+#endif /* __HT_USRNVMEM_H__ */
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
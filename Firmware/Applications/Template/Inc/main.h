@@ -77,6 +77,7 @@
 #define QMSG_ID_NW_DISCONNECT      (QMSG_ID_BASE + 3)
 #define QMSG_ID_SOCK_SENDPKG       (QMSG_ID_BASE + 4)
 #define QMSG_ID_SOCK_RECVPKG       (QMSG_ID_BASE + 5)
+#define QMSG_ID_NW_NONIP_READY     (QMSG_ID_BASE + 6)
 
 #define INIT_TASK_STACK_SIZE    (1024*6)
 #define RINGBUF_READY_FLAG      (0x06)
@@ -35,6 +35,15 @@ void SenseClima_Init(void);
  */
 void SenseClima_PublishDHT22State(void);
 
+/**
+ * @brief Lê o sensor DHT22, com novas tentativas em caso de falha.
+ * 
+ * @param temperature Temperatura lida em graus Celsius.
+ * @param humidity Umidade relativa lida em porcentagem.
+ * @return bool Verdadeiro se a leitura foi bem-sucedida.
+ */
+bool SenseClima_ReadDHT22(float *temperature, float *humidity);
+
 /**
  * @brief Obtém o intervalo de sono atual em milissegundos.
  * 
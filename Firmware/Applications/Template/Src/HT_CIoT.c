@@ -0,0 +1,98 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_CIoT.h"
+#include "main.h"
+#include "senseclima.h"
+#include "HT_Policy.h"
+#include <stdio.h>
+#include <string.h>
+
+// Frame em hexadecimal, como no +CSODCP: a API recebe a string do comando AT
+static char ciotHexFrame[HT_CIOT_FRAME_MAX_LEN * 2 + 1];
+
+// Intervalo recebido pelo callback do PS, aplicado por HT_CIoT_Process()
+static volatile uint32_t ciotPendingInterval = 0;
+
+static void HT_CIoT_Put16(uint8_t *p, uint16_t v) {
+    p[0] = (uint8_t)(v >> 8);
+    p[1] = (uint8_t)v;
+}
+
+bool HT_CIoT_SendBatch(void) {
+    static const char hex[] = "0123456789ABCDEF";
+    const HT_SamplesRetained_t *batch = HT_Samples_Get();
+    uint8_t frame[HT_CIOT_FRAME_MAX_LEN];
+    uint32_t interval_s = HT_Policy_SleepInterval() / 1000;
+    size_t len;
+    CmsRetId ret;
+
+    if (batch == NULL || batch->count == 0)
+        return false;
+
+    frame[0] = HT_CIOT_FRAME_READINGS;
+    HT_CIoT_Put16(&frame[1], batch->seq);
+    frame[3] = batch->count;
+    HT_CIoT_Put16(&frame[4], interval_s > 0xFFFF ? 0xFFFF : (uint16_t)interval_s);
+
+    len = HT_CIOT_HEADER_LEN;
+    for (uint8_t i = 0; i < batch->count; i++) {
+        HT_CIoT_Put16(&frame[len], (uint16_t)batch->temp_x10[i]);
+        HT_CIoT_Put16(&frame[len + 2], batch->hum_x10[i]);
+        len += HT_CIOT_READING_LEN;
+    }
+
+    for (size_t i = 0; i < len; i++) {
+        ciotHexFrame[2 * i] = hex[frame[i] >> 4];
+        ciotHexFrame[2 * i + 1] = hex[frame[i] & 0x0F];
+    }
+    ciotHexFrame[2 * len] = '\0';
+
+    printf("Enviando %u leituras pelo plano de controle (%u bytes, seq %u)\n", batch->count, (unsigned)len, batch->seq);
+    ret = appSetCSODCP(HT_CIOT_CID, (INT32)(2 * len), (UINT8 *)ciotHexFrame, HT_CIOT_RAI, CMI_PS_REGULAR_DATA);
+    if (ret != CMS_RET_SUCC) {
+        printf("Falha no envio CIoT: %d\n", ret);
+        return false;
+    }
+
+    HT_Samples_Uploaded();
+
+    return true;
+}
+
+void HT_CIoT_Downlink(const uint8_t *data, uint16_t len) {
+    uint32_t interval_s;
+
+    if (len < 5 || data[0] != HT_CIOT_CMD_SET_INTERVAL)
+        return;
+
+    interval_s = ((uint32_t)data[1] << 24) | ((uint32_t)data[2] << 16) | ((uint32_t)data[3] << 8) | data[4];
+    if (interval_s != 0)
+        ciotPendingInterval = interval_s;
+}
+
+void HT_CIoT_Process(void) {
+    uint32_t interval_s = ciotPendingInterval;
+
+    if (interval_s == 0)
+        return;
+
+    ciotPendingInterval = 0;
+    printf("Comando CIoT: novo intervalo de %lu segundos\n", interval_s);
+    if (interval_s > 86400 || !SenseClima_SetSleepIntervalValue(interval_s * 1000))
+        printf("FALHA AO ATUALIZAR INTERVALO: valor invalido\n");
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
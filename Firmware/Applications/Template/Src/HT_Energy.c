@@ -0,0 +1,176 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_Energy.h"
+#include "HT_MQTT_Api.h"
+#include "HT_Schedule.h"
+#include "main.h"
+#include <stdio.h>
+#include <string.h>
+
+#define HT_ENERGY_ELAPSED_MS(start) ((uint32_t)((xTaskGetTickCount() - (start)) * portTICK_PERIOD_MS))
+
+static const uint32_t energyPhaseUa[HT_ENERGY_PHASE_COUNT] = {
+    HT_ENERGY_UA_BOOT,
+    HT_ENERGY_UA_SIM,
+    HT_ENERGY_UA_ATTACH,
+    HT_ENERGY_UA_NET,
+    HT_ENERGY_UA_TLS,
+    HT_ENERGY_UA_MQTT,
+    HT_ENERGY_UA_SUBSCRIBE,
+    HT_ENERGY_UA_SENSE,
+    HT_ENERGY_UA_PUBLISH,
+    HT_ENERGY_UA_IDLE,
+    HT_ENERGY_UA_SLEEP,
+};
+
+static const char *const energyPhaseName[HT_ENERGY_PHASE_COUNT] = {
+    "boot", "sim", "attach", "net", "tls", "mqtt", "subscribe", "sense", "publish", "idle", "sleep",
+};
+
+// Tempos deste despertar, somados a memoria NV apenas em HT_Energy_EndWake()
+static uint32_t wakeMs[HT_ENERGY_PHASE_COUNT];
+static HT_EnergyPhase energyPhase = HT_ENERGY_PHASE_BOOT;
+static TickType_t energyPhaseStart = 0;
+static bool energyEnded = false;
+
+static char energyMsg[320];
+
+static uint32_t HT_Energy_ChargeUc(uint32_t ua, uint32_t ms) {
+    return (uint32_t)(((uint64_t)ua * ms) / 1000);
+}
+
+static uint32_t HT_Energy_AddSat(uint32_t a, uint32_t b) {
+    return (a > UINT32_MAX - b) ? UINT32_MAX : a + b;
+}
+
+void HT_Energy_Begin(void) {
+    memset(wakeMs, 0, sizeof(wakeMs));
+    energyPhase = HT_ENERGY_PHASE_BOOT;
+    energyPhaseStart = 0;
+    energyEnded = false;
+
+    // O tick comeca no inicio do escalonador: o tempo da ROM e do bootloader fica de fora
+    HT_Energy_Start(HT_ENERGY_PHASE_SIM);
+}
+
+HT_EnergyPhase HT_Energy_Start(HT_EnergyPhase phase) {
+    HT_EnergyPhase prev = energyPhase;
+    TickType_t now = xTaskGetTickCount();
+
+    if (phase >= HT_ENERGY_PHASE_COUNT || energyEnded)
+        return prev;
+
+    wakeMs[prev] += (uint32_t)((now - energyPhaseStart) * portTICK_PERIOD_MS);
+    energyPhase = phase;
+    energyPhaseStart = now;
+
+    return prev;
+}
+
+void HT_Energy_Move(HT_EnergyPhase from, HT_EnergyPhase to, uint32_t ms) {
+    if (from >= HT_ENERGY_PHASE_COUNT || to >= HT_ENERGY_PHASE_COUNT)
+        return;
+
+    if (ms > wakeMs[from])
+        ms = wakeMs[from];
+
+    wakeMs[from] -= ms;
+    wakeMs[to] += ms;
+}
+
+void HT_Energy_EndWake(uint32_t sleep_ms) {
+    HT_UsrNvMem_t *nv = HT_UsrNvMem_Get();
+    HT_EnergyRetained_t *stats;
+    uint32_t awake_ms = 0, wake_uc = 0, sleep_uc;
+
+    if (energyEnded)
+        return;
+
+    HT_Energy_Start(energyPhase);
+    energyEnded = true;
+
+    printf("\n=== ENERGIA DO DESPERTAR ===\n");
+    for (int i = 0; i < HT_ENERGY_PHASE_COUNT; i++) {
+        uint32_t uc = HT_Energy_ChargeUc(energyPhaseUa[i], wakeMs[i]);
+
+        if (wakeMs[i] != 0)
+            printf("%-10s %7lu ms %9lu uC\n", energyPhaseName[i], wakeMs[i], uc);
+        awake_ms += wakeMs[i];
+        wake_uc = HT_Energy_AddSat(wake_uc, uc);
+    }
+    printf("Total acordado: %lu ms, %lu uC\n", awake_ms, wake_uc);
+
+    if (nv == NULL)
+        return;
+
+    // Carga da hibernacao pelo intervalo pedido: o tempo real so e conhecido no proximo despertar
+    stats = &nv->energy;
+    sleep_uc = HT_Energy_ChargeUc(HT_ENERGY_UA_HIBERNATE, sleep_ms);
+
+    stats->wakes++;
+    for (int i = 0; i < HT_ENERGY_PHASE_COUNT; i++)
+        stats->phase_ms[i] = HT_Energy_AddSat(stats->phase_ms[i], wakeMs[i]);
+    stats->awake_uc = HT_Energy_AddSat(stats->awake_uc, wake_uc);
+    stats->sleep_s = HT_Energy_AddSat(stats->sleep_s, sleep_ms / 1000);
+    stats->sleep_uc = HT_Energy_AddSat(stats->sleep_uc, sleep_uc);
+    stats->last_wake_uc = wake_uc;
+
+    if (stats->avg_wake_uc == 0)
+        stats->avg_wake_uc = wake_uc;
+    else
+        stats->avg_wake_uc = stats->avg_wake_uc - (stats->avg_wake_uc >> HT_ENERGY_AVG_SHIFT) + (wake_uc >> HT_ENERGY_AVG_SHIFT);
+
+    stats->total_mc = HT_Energy_AddSat(stats->total_mc, (wake_uc + sleep_uc) / 1000);
+    HT_UsrNvMem_Update();
+}
+
+void HT_Energy_PublishSummary(MQTTClient *client) {
+    HT_UsrNvMem_t *nv = HT_UsrNvMem_Get();
+    HT_EnergyRetained_t *stats;
+    int len;
+
+    if (nv == NULL || !client->isconnected || !HT_Schedule_IsDue(HT_SCHEDULE_HEALTH))
+        return;
+
+    stats = &nv->energy;
+    len = snprintf(energyMsg, sizeof(energyMsg),
+                   "{\"seq\":%u,\"wakes\":%lu,\"awake_uc\":%lu,\"sleep_s\":%lu,\"sleep_uc\":%lu,\"avg_wake_uc\":%lu,\"total_mc\":%lu,\"ms\":[",
+                   stats->seq, stats->wakes, stats->awake_uc, stats->sleep_s, stats->sleep_uc, stats->avg_wake_uc, stats->total_mc);
+    for (int i = 0; i < HT_ENERGY_PHASE_COUNT && len > 0 && len < (int)sizeof(energyMsg); i++)
+        len += snprintf(&energyMsg[len], sizeof(energyMsg) - len, i ? ",%lu" : "%lu", stats->phase_ms[i]);
+    if (len > 0 && len < (int)sizeof(energyMsg))
+        len += snprintf(&energyMsg[len], sizeof(energyMsg) - len, "]}");
+    if (len <= 0 || len >= (int)sizeof(energyMsg))
+        return;
+
+    printf("Publicando resumo de energia (%lu despertares)\n", stats->wakes);
+    if (HT_MQTT_Publish(client, HT_ENERGY_SUMMARY_TOPIC, (uint8_t *)energyMsg, (uint32_t)len, QOS1, 0, 0, 0) != SUCCESS) {
+        printf("Resumo sem confirmacao do broker, janela mantida\n");
+        return;
+    }
+    HT_Schedule_Done(HT_SCHEDULE_HEALTH);
+
+    // Nova janela: a media e o total continuam
+    stats->seq++;
+    stats->wakes = 0;
+    memset(stats->phase_ms, 0, sizeof(stats->phase_ms));
+    stats->awake_uc = 0;
+    stats->sleep_s = 0;
+    stats->sleep_uc = 0;
+    HT_UsrNvMem_Update();
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,372 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_Fota.h"
+#include "main.h"
+#include "HT_MQTT_Api.h"
+#include "flash_qcx212.h"
+#include "os_exception.h"
+#include "mbedtls/sha256.h"
+#include <stdio.h>
+#include <string.h>
+
+#define HT_FOTA_MANIFEST_MAX_LEN    128                 /**</ Largest manifest payload accepted. */
+#define HT_FOTA_READ_LEN            256                 /**</ Flash read size while hashing. */
+
+/* Estado da mensagem de chunk em recepcao (somente RAM, descartado em caso de falha) */
+static struct {
+    uint8_t skip;
+    uint8_t hdr_len;
+    uint8_t hdr[HT_FOTA_CHUNK_HDR_LEN];
+    uint32_t base;
+    uint32_t written;
+} fotaRx;
+
+static uint8_t fotaReadBuf[HT_FOTA_READ_LEN];
+static char fotaMsg[HT_FOTA_VERSION_LEN + 32];
+static uint8_t fotaRequestPending = 0;
+static uint32_t fotaChunksSinceFlush = 0;
+static TickType_t fotaLastProgress = 0;
+static TickType_t fotaWakeStart = 0;
+
+static HT_FotaRetained_t *HT_FOTA_Retained(void) {
+    HT_UsrNvMem_t *mem = HT_UsrNvMem_Get();
+
+    return (mem != NULL) ? &mem->fota : NULL;
+}
+
+static void HT_FOTA_PublishStatus(MQTTClient *client, const char *topic, HT_FotaRetained_t *fota, const char *result) {
+    int len = snprintf(fotaMsg, sizeof(fotaMsg), "%s %s", fota->version, result);
+
+    if (client->isconnected && len > 0)
+        HT_MQTT_Publish(client, (char *)topic, (uint8_t *)fotaMsg, (uint32_t)len, QOS0, 0, 0, 0);
+}
+
+static bool HT_FOTA_TopicIs(MQTTString *topicName, const char *topic) {
+    size_t len = strlen(topic);
+
+    return topicName->lenstring.len == (int)len && memcmp(topicName->lenstring.data, topic, len) == 0;
+}
+
+static bool HT_FOTA_HexDecode(const char *hex, uint8_t *out, size_t out_len) {
+    for (size_t i = 0; i < out_len * 2; i++) {
+        char c = hex[i];
+        uint8_t v;
+
+        if (c >= '0' && c <= '9')
+            v = c - '0';
+        else if (c >= 'a' && c <= 'f')
+            v = c - 'a' + 10;
+        else if (c >= 'A' && c <= 'F')
+            v = c - 'A' + 10;
+        else
+            return false;
+
+        out[i / 2] = (i & 1) ? (out[i / 2] | v) : (v << 4);
+    }
+
+    return hex[out_len * 2] == '\0';
+}
+
+static void HT_FOTA_ManifestCallback(MessageData *msg) {
+    HT_FotaRetained_t *fota = HT_FOTA_Retained();
+    char buffer[HT_FOTA_MANIFEST_MAX_LEN];
+    char version[HT_FOTA_VERSION_LEN];
+    char sha_hex[HT_FOTA_SHA256_LEN * 2 + 1];
+    uint8_t sha256[HT_FOTA_SHA256_LEN];
+    unsigned long size = 0;
+
+    // Mensagem retida vazia apenas limpa o manifesto no broker
+    if (fota == NULL || msg->message->payloadlen == 0)
+        return;
+
+    if (msg->message->payloadlen >= sizeof(buffer)) {
+        printf("FOTA: manifesto muito grande, ignorado\n");
+        return;
+    }
+
+    memcpy(buffer, msg->message->payload, msg->message->payloadlen);
+    buffer[msg->message->payloadlen] = '\0';
+
+    if (sscanf(buffer, "%15s %lu %64s", version, &size, sha_hex) != 3 || !HT_FOTA_HexDecode(sha_hex, sha256, sizeof(sha256))) {
+        printf("FOTA: manifesto invalido: '%s'\n", buffer);
+        return;
+    }
+
+    if (size == 0 || size > HT_FOTA_MAX_IMAGE_SIZE) {
+        printf("FOTA: tamanho de imagem invalido (%lu bytes, maximo %lu)\n", size, (unsigned long)HT_FOTA_MAX_IMAGE_SIZE);
+        return;
+    }
+
+    // Mesma imagem: retoma o download do ponto salvo ou ignora se ja foi entregue
+    if (strcmp(version, fota->version) == 0 && fota->image_size == size && memcmp(fota->sha256, sha256, sizeof(sha256)) == 0) {
+        if (fota->state == HT_FOTA_DOWNLOADING) {
+            printf("FOTA: retomando versao %s em %lu de %lu bytes\n", fota->version, fota->contiguous, fota->image_size);
+            fotaRequestPending = 1;
+        }
+        return;
+    }
+
+    printf("FOTA: nova versao %s (%lu bytes)\n", version, size);
+
+    fota->state = HT_FOTA_DOWNLOADING;
+    fota->image_size = size;
+    fota->contiguous = 0;
+    memcpy(fota->sha256, sha256, sizeof(sha256));
+    memcpy(fota->version, version, sizeof(version));
+    HT_UsrNvMem_Flush();
+
+    fotaChunksSinceFlush = 0;
+    fotaLastProgress = xTaskGetTickCount();
+    fotaRequestPending = 1;
+}
+
+static void HT_FOTA_ChunkCallback(MessageData *msg) {
+    // Chunks cabem no buffer de leitura apenas se o servidor nao completou o ultimo chunk
+    printf("FOTA: chunk de %d bytes fora do formato, ignorado\n", (int)msg->message->payloadlen);
+}
+
+static int HT_FOTA_WriteChunk(HT_FotaRetained_t *fota, unsigned char *data, int len) {
+    uint32_t n;
+
+    // Os primeiros bytes da mensagem sao o offset da imagem
+    while (len > 0 && fotaRx.hdr_len < HT_FOTA_CHUNK_HDR_LEN) {
+        fotaRx.hdr[fotaRx.hdr_len++] = *data++;
+        len--;
+
+        if (fotaRx.hdr_len == HT_FOTA_CHUNK_HDR_LEN) {
+            fotaRx.base = ((uint32_t)fotaRx.hdr[0] << 24) | ((uint32_t)fotaRx.hdr[1] << 16) |
+                          ((uint32_t)fotaRx.hdr[2] << 8) | fotaRx.hdr[3];
+
+            // So aceita o chunk que continua a parte contigua; repeticoes e saltos sao descartados
+            if (fotaRx.base != fota->contiguous || fotaRx.base >= fota->image_size) {
+                fotaRx.skip = 1;
+                return SUCCESS;
+            }
+
+            if (BSP_QSPI_Erase_Safe(FLASH_FOTA_REGION_START + fotaRx.base, HT_FOTA_SECTOR_SIZE) != QSPI_OK) {
+                printf("FOTA: falha ao apagar setor em %lu\n", fotaRx.base);
+                return FAILURE;
+            }
+        }
+    }
+
+    // Descarta o preenchimento depois do fim da imagem
+    n = fota->image_size - fotaRx.base - fotaRx.written;
+    if ((uint32_t)len < n)
+        n = (uint32_t)len;
+
+    if (n > 0 && BSP_QSPI_Write_Safe(data, FLASH_FOTA_REGION_START + fotaRx.base + fotaRx.written, n) != QSPI_OK) {
+        printf("FOTA: falha ao gravar em %lu\n", fotaRx.base + fotaRx.written);
+        return FAILURE;
+    }
+    fotaRx.written += n;
+
+    return SUCCESS;
+}
+
+static void HT_FOTA_CommitChunk(HT_FotaRetained_t *fota) {
+    uint32_t expected = fota->image_size - fotaRx.base;
+
+    if (expected > HT_FOTA_CHUNK_LEN)
+        expected = HT_FOTA_CHUNK_LEN;
+
+    if (fotaRx.hdr_len < HT_FOTA_CHUNK_HDR_LEN || fotaRx.written != expected)
+        return;
+
+    fota->contiguous = fotaRx.base + fotaRx.written;
+    fotaLastProgress = xTaskGetTickCount();
+
+    if (fota->contiguous == fota->image_size) {
+        printf("FOTA: download completo (%lu bytes)\n", fota->image_size);
+        fota->state = HT_FOTA_VERIFYING;
+        HT_UsrNvMem_Flush();
+    } else if (++fotaChunksSinceFlush >= HT_FOTA_FLUSH_EVERY) {
+        // Hibernacao grava a NV sozinha; o flush periodico cobre um reset inesperado
+        fotaChunksSinceFlush = 0;
+        HT_UsrNvMem_Flush();
+    } else {
+        HT_UsrNvMem_Update();
+    }
+}
+
+static int HT_FOTA_StreamHandler(MQTTStreamData *sd) {
+    HT_FotaRetained_t *fota = HT_FOTA_Retained();
+
+    switch (sd->event) {
+    case MQTT_STREAM_BEGIN:
+        memset(&fotaRx, 0, sizeof(fotaRx));
+        // Outras mensagens grandes sao consumidas e confirmadas sem uso, como sem o handler
+        fotaRx.skip = fota == NULL || fota->state != HT_FOTA_DOWNLOADING ||
+                      !HT_FOTA_TopicIs(sd->topicName, HT_FOTA_CHUNK_TOPIC) ||
+                      sd->total_len != HT_FOTA_CHUNK_HDR_LEN + HT_FOTA_CHUNK_LEN;
+        return SUCCESS;
+    case MQTT_STREAM_CHUNK:
+        return fotaRx.skip ? SUCCESS : HT_FOTA_WriteChunk(fota, sd->chunk, sd->chunk_len);
+    case MQTT_STREAM_END:
+        if (!fotaRx.skip)
+            HT_FOTA_CommitChunk(fota);
+        return SUCCESS;
+    case MQTT_STREAM_ABORT:
+    default:
+        // Setor parcialmente gravado sera apagado de novo quando o chunk for reenviado
+        fotaRx.skip = 1;
+        return SUCCESS;
+    }
+}
+
+static void HT_FOTA_Request(MQTTClient *client, HT_FotaRetained_t *fota) {
+    int len = snprintf(fotaMsg, sizeof(fotaMsg), "%s %lu", fota->version, fota->contiguous);
+
+    printf("FOTA: solicitando versao %s a partir de %lu\n", fota->version, fota->contiguous);
+    HT_MQTT_Publish(client, HT_FOTA_REQUEST_TOPIC, (uint8_t *)fotaMsg, (uint32_t)len, QOS0, 0, 0, 0);
+
+    fotaRequestPending = 0;
+    fotaLastProgress = xTaskGetTickCount();
+}
+
+static bool HT_FOTA_CheckImage(HT_FotaRetained_t *fota) {
+    mbedtls_sha256_context ctx;
+    uint8_t digest[HT_FOTA_SHA256_LEN];
+    uint32_t offset = 0;
+    int ret;
+
+    mbedtls_sha256_init(&ctx);
+    ret = mbedtls_sha256_starts_ret(&ctx, 0);
+
+    // Le de volta o que foi gravado: valida a transferencia e a escrita na flash
+    while (ret == 0 && offset < fota->image_size) {
+        uint32_t n = fota->image_size - offset;
+
+        if (n > sizeof(fotaReadBuf))
+            n = sizeof(fotaReadBuf);
+
+        if (BSP_QSPI_Read_Safe(fotaReadBuf, FLASH_FOTA_REGION_START + offset, n) != QSPI_OK) {
+            ret = -1;
+            break;
+        }
+
+        ret = mbedtls_sha256_update_ret(&ctx, fotaReadBuf, n);
+        offset += n;
+    }
+
+    if (ret == 0)
+        ret = mbedtls_sha256_finish_ret(&ctx, digest);
+    mbedtls_sha256_free(&ctx);
+
+    return ret == 0 && memcmp(digest, fota->sha256, sizeof(digest)) == 0;
+}
+
+static void HT_FOTA_Handoff(MQTTClient *client, HT_FotaRetained_t *fota) {
+    HT_FotaHandoff_t record;
+
+    memset(&record, 0, sizeof(record));
+    record.magic = HT_FOTA_HANDOFF_MAGIC;
+    record.image_size = fota->image_size;
+    memcpy(record.sha256, fota->sha256, sizeof(record.sha256));
+    memcpy(record.version, fota->version, sizeof(record.version));
+
+    if (BSP_QSPI_Erase_Safe(HT_FOTA_HANDOFF_ADDR, HT_FOTA_SECTOR_SIZE) != QSPI_OK ||
+        BSP_QSPI_Write_Safe((uint8_t *)&record, HT_FOTA_HANDOFF_ADDR, sizeof(record)) != QSPI_OK) {
+        printf("FOTA: falha ao gravar registro para o bootloader\n");
+        HT_FOTA_PublishStatus(client, HT_FOTA_STATUS_TOPIC, fota, "erro flash");
+        fota->state = HT_FOTA_IDLE;
+        fota->version[0] = '\0';
+        HT_UsrNvMem_Flush();
+        return;
+    }
+
+    fota->state = HT_FOTA_HANDOFF;
+    HT_UsrNvMem_Flush();
+
+    HT_FOTA_PublishStatus(client, HT_FOTA_STATUS_TOPIC, fota, "verificado");
+    if (client->isconnected)
+        MQTTDisconnect(client);
+
+    printf("FOTA: imagem %s verificada, reiniciando para o bootloader\n", fota->version);
+    osDelay(500);
+    EC_SystemReset();
+}
+
+void HT_FOTA_Init(MQTTClient *client) {
+    HT_FotaRetained_t *fota = HT_FOTA_Retained();
+
+    fotaWakeStart = xTaskGetTickCount();
+    fotaLastProgress = fotaWakeStart;
+
+    MQTTSetStreamHandler(client, HT_FOTA_StreamHandler);
+    MQTTSubscribe(client, HT_FOTA_MANIFEST_TOPIC, QOS1, HT_FOTA_ManifestCallback);
+    MQTTSubscribe(client, HT_FOTA_CHUNK_TOPIC, QOS1, HT_FOTA_ChunkCallback);
+
+    if (fota == NULL)
+        return;
+
+    switch (fota->state) {
+    case HT_FOTA_DOWNLOADING:
+        printf("FOTA: download da versao %s pendente em %lu de %lu bytes\n", fota->version, fota->contiguous, fota->image_size);
+        fotaRequestPending = 1;
+        break;
+    case HT_FOTA_HANDOFF:
+        // Primeiro boot apos a entrega: a versao fica registrada para ignorar o mesmo manifesto
+        HT_FOTA_PublishStatus(client, HT_FOTA_STATUS_TOPIC, fota, "reiniciado");
+        fota->state = HT_FOTA_IDLE;
+        HT_UsrNvMem_Update();
+        break;
+    default:
+        break;
+    }
+}
+
+void HT_FOTA_Process(MQTTClient *client) {
+    HT_FotaRetained_t *fota = HT_FOTA_Retained();
+
+    if (fota == NULL || !client->isconnected)
+        return;
+
+    switch (fota->state) {
+    case HT_FOTA_DOWNLOADING:
+        if (fotaRequestPending || (xTaskGetTickCount() - fotaLastProgress) >= pdMS_TO_TICKS(HT_FOTA_STALL_TIMEOUT_MS))
+            HT_FOTA_Request(client, fota);
+
+        // Sem task de recepcao no TLS: os chunks so sao lidos dentro do yield
+        MQTTYield(client, HT_FOTA_YIELD_MS);
+        break;
+    case HT_FOTA_VERIFYING:
+        if (HT_FOTA_CheckImage(fota)) {
+            HT_FOTA_Handoff(client, fota);
+        } else {
+            printf("FOTA: SHA-256 da versao %s nao confere, descartando\n", fota->version);
+            HT_FOTA_PublishStatus(client, HT_FOTA_STATUS_TOPIC, fota, "erro sha256");
+            fota->state = HT_FOTA_IDLE;
+            fota->contiguous = 0;
+            fota->version[0] = '\0';
+            HT_UsrNvMem_Flush();
+        }
+        break;
+    default:
+        break;
+    }
+}
+
+bool HT_FOTA_IsBusy(void) {
+    HT_FotaRetained_t *fota = HT_FOTA_Retained();
+
+    if (fota == NULL || (fota->state != HT_FOTA_DOWNLOADING && fota->state != HT_FOTA_VERIFYING))
+        return false;
+
+    return (xTaskGetTickCount() - fotaWakeStart) < pdMS_TO_TICKS(HT_FOTA_AWAKE_BUDGET_MS);
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
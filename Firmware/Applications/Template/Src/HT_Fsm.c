@@ -17,6 +17,15 @@
 #include "HT_DHT22.h"
 #include "senseclima.h"
 #include "HT_Sleep.h"
+#include "HT_Fota.h"
+#include "HT_CIoT.h"
+#include "HT_Energy.h"
+#include "HT_Policy.h"
+#include "HT_Samples.h"
+#include "HT_Schedule.h"
+#if MQTT_TLS_ENABLE == 1
+#include "HT_MQTT_Tls.h"
+#endif
 
 /* Declaracoes externas ------------------------------------------------------------------*/
 extern void HT_LED_GreenLedTask(void *arg);
@@ -201,7 +210,12 @@ Network mqttNetwork;
 
 //Buffer that will be published.
 static uint8_t mqtt_payload[128] = {"Undefined Button"};
+#if MQTT_TLS_ENABLE == 1 && HT_MQTT_TLS_ZERO_COPY == 1
+// Com TLS os pacotes sao montados no buffer de saida do proprio TLS
+#define mqttSendbuf NULL
+#else
 static uint8_t mqttSendbuf[HT_MQTT_BUFFER_SIZE] = {0};
+#endif
 static uint8_t mqttReadbuf[HT_MQTT_BUFFER_SIZE] = {0};
 
 static const char clientID[] = {"SIP_HTNB32L"};
@@ -321,10 +335,22 @@ static void HT_FSM_LedStatus(HT_Led_Type led, uint16_t state) {
 }
 
 HT_ConnectionStatus HT_FSM_MQTTConnect(void) {
+    const HT_MQTT_ConnectProfile *profile;
+    HT_EnergyPhase prev_phase;
+    uint8_t ret;
 
     // Connect to MQTT Broker using client, network and parameters needded. 
-    if(HT_MQTT_Connect(&mqttClient, &mqttNetwork, (char *)addr, HT_MQTT_PORT, HT_MQTT_SEND_TIMEOUT, HT_MQTT_RECEIVE_TIMEOUT,
-                (char *)clientID, (char *)username, (char *)password, HT_MQTT_VERSION, HT_MQTT_KEEP_ALIVE_INTERVAL, mqttSendbuf, HT_MQTT_BUFFER_SIZE, mqttReadbuf, HT_MQTT_BUFFER_SIZE)) {
+    prev_phase = HT_Energy_Start(HT_ENERGY_PHASE_NET);
+    ret = HT_MQTT_Connect(&mqttClient, &mqttNetwork, (char *)addr, HT_MQTT_PORT, HT_MQTT_SEND_TIMEOUT, HT_MQTT_RECEIVE_TIMEOUT,
+                (char *)clientID, (char *)username, (char *)password, HT_MQTT_VERSION, HT_MQTT_KEEP_ALIVE_INTERVAL, mqttSendbuf, HT_MQTT_BUFFER_SIZE, mqttReadbuf, HT_MQTT_BUFFER_SIZE);
+
+    // A conexao inteira fica em NET; o perfil do connect separa o TLS e o CONNECT
+    HT_Energy_Start(prev_phase);
+    profile = HT_MQTT_GetConnectProfile();
+    HT_Energy_Move(HT_ENERGY_PHASE_NET, HT_ENERGY_PHASE_TLS, profile->tls_ms);
+    HT_Energy_Move(HT_ENERGY_PHASE_NET, HT_ENERGY_PHASE_MQTT, profile->mqtt_ms);
+
+    if(ret) {
         return HT_NOT_CONNECTED;   
     }
 
@@ -353,23 +379,46 @@ static void HT_FSM_SubscribeHandleState(void) {
 static void HT_FSM_MQTTPublishDHT22State(void) {
     // Chama a função que lê e publica os dados do sensor
     SenseClima_PublishDHT22State();
+    HT_Schedule_Done(HT_SCHEDULE_SAMPLE);
+
+    // Leituras guardadas pelos despertares sem rede
+    if (HT_Samples_Publish(&mqttClient))
+        HT_Schedule_Done(HT_SCHEDULE_UPLOAD);
+
+    // Resumo de energia quando o prazo de saude vence
+    HT_Energy_PublishSummary(&mqttClient);
+    HT_Energy_Start(HT_ENERGY_PHASE_IDLE);
 
     // Define o próximo estado como entrar em sono profundo
     state = HT_ENTER_DEEP_SLEEP_STATE;
 }
 
 static void HT_FSM_EnterDeepSleepState(void) {
-    // Obtem o intervalo de sono atual (configurado via MQTT ou valor padrao)
-    const uint32_t sleep_duration_ms = SenseClima_GetSleepInterval();
+    // Intervalo configurado (MQTT ou padrao) alongado pela politica de bateria e cobertura
+    const uint32_t sleep_duration_ms = HT_Policy_SleepInterval();
+
+    HT_Energy_Start(HT_ENERGY_PHASE_SLEEP);
     printf("\n=== PREPARANDO PARA HIBERNACAO ===\n");
-    printf("Intervalo configurado: %lu ms (%lu segundos)\n", 
-           sleep_duration_ms, sleep_duration_ms / 1000);
+    printf("Intervalo de leitura: %lu ms (%lu segundos), envio a cada %lu segundos\n", 
+           sleep_duration_ms, sleep_duration_ms / 1000, HT_Schedule_Period(HT_SCHEDULE_UPLOAD) / 1000);
     
     // Desconecta do MQTT para limpar recursos
     if (mqttClient.isconnected) {
         printf("Desconectando do MQTT antes de dormir...\n");
+#if HT_MQTT_RAI_ENABLE == 1
+        // O DISCONNECT e o ultimo envio do ciclo: o socket nao e fechado antes da hibernacao
+        MQTTSetReleaseAssist(&mqttClient, MQTT_RAI_NO_FURTHER_DATA);
+#endif
         MQTTDisconnect(&mqttClient);
+#if MQTT_TLS_ENABLE == 1
+        // Depois do DISCONNECT com RAI o socket fica aberto: um FIN acordaria o radio de novo
+        HT_MQTT_TLSRelease(HT_MQTT_RAI_ENABLE != 1);
+#endif
     }
+#if MQTT_TLS_ENABLE == 1
+    // Fim do despertar: o contexto TLS e liberado e a arena do mbedTLS volta a um bloco livre
+    HT_MQTT_TLSRelease(true);
+#endif
     
     // Desativa todos os perifericos que possam impedir o sono profundo
     printf("Desativando perifericos...\n");
@@ -384,11 +433,64 @@ static void HT_FSM_EnterDeepSleepState(void) {
     
     // Entra no modo de hibernacao - esta funcao nao retorna
     printf("Entrando em hibernacao...\n");
-    HT_Sleep_EnterSleep(SLP_HIB_STATE, sleep_duration_ms);
+    HT_Sleep_EnterSleep(SLP_HIB_STATE);
     
     // Este codigo nunca sera alcancado
 }
 
+#if HT_CIOT_ENABLE == 1
+static void HT_FSM_CIoTCycle(void) {
+    float temperature = 0, humidity = 0;
+    bool valid;
+
+    printf("\n=== LEITURA SENSOR DHT22 (CIoT) ===\n");
+    HT_Energy_Start(HT_ENERGY_PHASE_SENSE);
+    valid = SenseClima_ReadDHT22(&temperature, &humidity);
+    HT_Samples_Add(valid, temperature, humidity);
+    HT_Schedule_Done(HT_SCHEDULE_SAMPLE);
+
+    HT_Energy_Start(HT_ENERGY_PHASE_PUBLISH);
+    if ((HT_Samples_Count() >= HT_Samples_PerUpload() || HT_Schedule_IsDue(HT_SCHEDULE_UPLOAD)) && HT_CIoT_SendBatch()) {
+        HT_Schedule_Done(HT_SCHEDULE_UPLOAD);
+        // Janela para um comando entregue logo apos o relatorio
+        osDelay(HT_CIOT_DOWNLINK_WAIT_MS);
+    }
+    HT_CIoT_Process();
+
+    HT_FSM_EnterDeepSleepState();
+}
+#endif
+
+static void HT_FSM_DeferUploadState(void) {
+    float temperature = 0, humidity = 0;
+    bool valid;
+
+    printf("\n=== LEITURA SENSOR DHT22 (envio adiado) ===\n");
+    HT_Energy_Start(HT_ENERGY_PHASE_SENSE);
+    valid = SenseClima_ReadDHT22(&temperature, &humidity);
+    HT_Samples_Add(valid, temperature, humidity);
+    HT_Schedule_Done(HT_SCHEDULE_SAMPLE);
+
+    HT_FSM_EnterDeepSleepState();
+}
+
+void HT_FSM_SampleOnlyWake(void) {
+    float temperature = 0, humidity = 0;
+    bool valid;
+
+    // Despertar da pilha (TAU em PSM) sem prazo da aplicacao: volta a dormir
+    if (HT_Schedule_IsDue(HT_SCHEDULE_SAMPLE)) {
+        printf("\n=== LEITURA SENSOR DHT22 (sem rede, %u de %u) ===\n", HT_Samples_Count() + 1, HT_Samples_PerUpload());
+        HT_Energy_Start(HT_ENERGY_PHASE_SENSE);
+        DHT22_Init();
+        valid = SenseClima_ReadDHT22(&temperature, &humidity);
+        HT_Samples_Add(valid, temperature, humidity);
+        HT_Schedule_Done(HT_SCHEDULE_SAMPLE);
+    }
+
+    HT_Sleep_EnterSleepOffline(SLP_HIB_STATE);
+}
+
 static void HT_FSM_MQTTPublishState(void) {
 
     // Publishes payload defined from the button color with QOS 0 and not retain message
@@ -478,12 +580,23 @@ void HT_Fsm(void) {
     bool mqtt_connected = false;
 
     // Inicializa o sensor DHT22
+    HT_Energy_Start(HT_ENERGY_PHASE_SENSE);
     DHT22_Init();
     
     // Inicializa o módulo SenseClima (carrega configurações da NVRAM)
     SenseClima_Init();
     
     printf("Intervalo de sono: %lu ms\n", SenseClima_GetSleepInterval());
+    HT_Energy_Start(HT_ENERGY_PHASE_IDLE);
+
+    // Cobertura ruim e nada urgente: guarda a leitura e tenta enviar em outro despertar
+    if (HT_Policy_DeferUpload() && !HT_FOTA_IsBusy())
+        HT_FSM_DeferUploadState();
+
+#if HT_CIOT_ENABLE == 1
+    // Sem MQTT: le, envia pelo plano de controle e hiberna
+    HT_FSM_CIoTCycle();
+#endif
 
     // Loop para tentar conectar ao MQTT até o número máximo de tentativas
     while (mqtt_connect_attempts < MAX_MQTT_CONNECT_ATTEMPTS && !mqtt_connected) {
@@ -516,7 +629,7 @@ void HT_Fsm(void) {
         HT_FSM_LedStatus(HT_GREEN_LED, LED_OFF);
         
         // Entra em hibernação usando o intervalo padrão ou configurado
-        HT_Sleep_EnterSleep(SLP_HIB_STATE, SenseClima_GetSleepInterval());
+        HT_Sleep_EnterSleep(SLP_HIB_STATE);
         
         // Este código nunca será alcançado
         return;
@@ -532,10 +645,14 @@ void HT_Fsm(void) {
     printf("Executando FSM...\n");
 
     // Subscreve ao tópico de intervalo
+    HT_Energy_Start(HT_ENERGY_PHASE_SUBSCRIBE);
     printf("Inscrevendo no topico: '%s' com QoS 1\n", INTERVAL_TOPIC);
     HT_MQTT_Subscribe(&mqttClient, INTERVAL_TOPIC, QOS1);
     printf("Inscricao enviada\n");
 
+    // Atualizacao de firmware: retoma um download pendente
+    HT_FOTA_Init(&mqttClient);
+
     // Usa o tick count do FreeRTOS para um controle de tempo mais preciso.
     TickType_t last_dht_read_time = xTaskGetTickCount();
     const TickType_t dht_read_interval = pdMS_TO_TICKS(30000); // 30 segundos
@@ -544,6 +661,10 @@ void HT_Fsm(void) {
     state = HT_MQTT_PUBLISH_DHT22_STATE;
 
     while (1) {
+        // Trata as mensagens recebidas fora do caminho de I/O do MQTT
+        MQTTInboundDispatch(&mqttClient, 0);
+        HT_FOTA_Process(&mqttClient);
+
         switch (state) {
             case HT_CHECK_SOCKET_STATE:
                 // Check if some message arrived
@@ -577,6 +698,11 @@ void HT_Fsm(void) {
                 HT_FSM_MQTTPublishDHT22State();
                 break;
             case HT_ENTER_DEEP_SLEEP_STATE:
+                // Adia o sono enquanto houver download de firmware dentro do limite da janela
+                if (HT_FOTA_IsBusy()) {
+                    state = HT_WAIT_FOR_BUTTON_STATE;
+                    break;
+                }
                 HT_FSM_EnterDeepSleepState();
                 break;
             default:
@@ -15,24 +15,161 @@
 
 #include "HT_MQTT_Api.h"
 #include "HT_Fsm.h"
+#if MQTT_TLS_ENABLE == 1
 #include "HT_MQTT_Tls.h"
+#include "HT_UsrNvMem.h"
+#include "HT_TLS_Psk.h"
+#include "HT_TrustStore.h"
+#endif
 #include "senseclima.h"
+#include <inttypes.h>
 
 extern volatile uint8_t subscribe_callback;
 
+#define HT_MQTT_ELAPSED_MS(start) ((uint32_t)((xTaskGetTickCount() - (start)) * portTICK_PERIOD_MS))
+
 static MQTTPacket_connectData connectData = MQTTPacket_connectData_initializer;
+static HT_MQTT_ConnectProfile connectProfile;
 
 #if  MQTT_TLS_ENABLE == 1
 static MqttClientContext mqtt_client_ctx;
+static uint8_t tlsSessionBuf[HT_TLS_SESSION_MAX_LEN];
+#endif
+
+// Copias terminadas em null usadas pelo callback de subscribe (chamado sempre pela mesma task)
+static char subPayloadStr[HT_MQTT_SUB_PAYLOAD_MAX_LEN + 1];
+static char subTopicStr[HT_MQTT_SUB_TOPIC_MAX_LEN + 1];
+
+#if  MQTT_TLS_ENABLE == 1
+static uint32_t HT_MQTT_HostHash(const char *host) {
+    uint32_t hash = 2166136261u;
+
+    // FNV-1a: identifica o broker da sessao sem guardar o nome inteiro
+    while (*host)
+        hash = (hash ^ (uint8_t)*host++) * 16777619u;
+
+    // Sessoes PSK e por certificado do mesmo broker nao sao intercambiaveis
+    return (hash ^ (mqtt_client_ctx.psk != NULL)) * 16777619u;
+}
+
+static void HT_MQTT_TLSSelectAuth(void) {
+    const uint8_t *data;
+    size_t len;
+
+    mqtt_client_ctx.psk = NULL;
+    mqtt_client_ctx.pskLen = 0;
+    mqtt_client_ctx.pskIdentity = NULL;
+    mqtt_client_ctx.pskIdentityLen = 0;
+    mqtt_client_ctx.caCert = NULL;
+    mqtt_client_ctx.caCertLen = 0;
+    mqtt_client_ctx.clientCert = NULL;
+    mqtt_client_ctx.clientCertLen = 0;
+    mqtt_client_ctx.clientPk = NULL;
+    mqtt_client_ctx.clientPkLen = 0;
+    mqtt_client_ctx.serverPins = NULL;
+    mqtt_client_ctx.serverPinCount = 0;
+
+#if HT_MQTT_TLS_PSK_ENABLE == 1
+    if (HT_PSK_Load(&mqtt_client_ctx.pskIdentity, &mqtt_client_ctx.pskIdentityLen,
+                    &mqtt_client_ctx.psk, &mqtt_client_ctx.pskLen))
+        return;
+#endif
+
+    // Sem PSK: certificados DER lidos direto da flash (XIP), sem copia nem base64
+    if (HT_TrustStore_Get(HT_TRUST_CA_CERT, &data, &len)) {
+        mqtt_client_ctx.caCert = (const char *)data;
+        mqtt_client_ctx.caCertLen = len;
+    }
+
+    if (HT_TrustStore_Get(HT_TRUST_CLIENT_CERT, &data, &len)) {
+        mqtt_client_ctx.clientCert = (const char *)data;
+        mqtt_client_ctx.clientCertLen = len;
+    }
+
+    if (HT_TrustStore_Get(HT_TRUST_CLIENT_KEY, &data, &len)) {
+        mqtt_client_ctx.clientPk = (const char *)data;
+        mqtt_client_ctx.clientPkLen = len;
+    }
+
+    if (HT_TrustStore_Get(HT_TRUST_SERVER_PINS, &data, &len) && len >= HT_TRUST_PIN_LEN) {
+        mqtt_client_ctx.serverPins = data;
+        mqtt_client_ctx.serverPinCount = len / HT_TRUST_PIN_LEN;
+    }
+}
+
+static void HT_MQTT_TLSSessionLoad(HT_TlsSessionRetained_t *retained, char *addr, int32_t port) {
+    mqtt_client_ctx.session = NULL;
+    mqtt_client_ctx.sessionLen = 0;
+
+    if (retained == NULL || retained->len == 0 || retained->len > sizeof(retained->data))
+        return;
+
+    if (retained->port != (uint16_t)port || retained->host_hash != HT_MQTT_HostHash(addr))
+        return;
+
+    mqtt_client_ctx.session = retained->data;
+    mqtt_client_ctx.sessionLen = retained->len;
+}
+
+static void HT_MQTT_TLSSessionStore(HT_TlsSessionRetained_t *retained, char *addr, int32_t port) {
+    uint32_t host_hash = HT_MQTT_HostHash(addr);
+    size_t len = 0;
+
+    if (retained == NULL)
+        return;
+
+    if (HT_MQTT_TLSSessionSave(tlsSessionBuf, sizeof(tlsSessionBuf), &len) != 0) {
+        printf("Sessao TLS nao pode ser salva (%u bytes)\n", (unsigned)len);
+        return;
+    }
+
+    // A NV so e marcada para gravacao quando a sessao (ou o ticket) mudou
+    if (retained->len == len && retained->port == (uint16_t)port && retained->host_hash == host_hash &&
+            !memcmp(retained->data, tlsSessionBuf, len))
+        return;
+
+    memcpy(retained->data, tlsSessionBuf, len);
+    retained->len = (uint16_t)len;
+    retained->port = (uint16_t)port;
+    retained->host_hash = host_hash;
+    HT_UsrNvMem_Update();
+}
+
+static void HT_MQTT_TLSPrintProfile(void) {
+    // Nomes na ordem de mbedtls_ssl_states
+    static const char *const names[HT_MQTT_TLS_PROFILE_STATES] = {
+        "HELLO_REQUEST", "CLIENT_HELLO", "SERVER_HELLO", "SERVER_CERTIFICATE", "SERVER_KEY_EXCHANGE",
+        "CERTIFICATE_REQUEST", "SERVER_HELLO_DONE", "CLIENT_CERTIFICATE", "CLIENT_KEY_EXCHANGE",
+        "CERTIFICATE_VERIFY", "CLIENT_CHANGE_CIPHER_SPEC", "CLIENT_FINISHED", "SERVER_CHANGE_CIPHER_SPEC",
+        "SERVER_FINISHED", "FLUSH_BUFFERS", "HANDSHAKE_WRAPUP", "HANDSHAKE_OVER", "SERVER_NEW_SESSION_TICKET",
+        "HELLO_VERIFY_REQUEST_SENT"
+    };
+    const HT_MQTT_TLSProfile *prof = HT_MQTT_TLSGetProfile();
+
+    printf("Perfil TLS: tentativas %u, tcp %lu ms, handshake %lu ms, tx %lu B, rx %lu B, heap pico %lu B\n",
+           prof->attempts, prof->tcp_ms, prof->handshake_ms, prof->tx_bytes, prof->rx_bytes, prof->heap_peak);
+    printf("  arena mbedTLS: pico %lu B, em uso %lu B\n", prof->arena_peak, prof->arena_used);
+    if (prof->setup)
+        printf("  seed DRBG %lu ms, parse certificados %lu ms\n", prof->seed_ms, prof->parse_ms);
+
+    for (int i = 0; i < HT_MQTT_TLS_PROFILE_STATES; i++) {
+        if (prof->state[i].steps == 0)
+            continue;
+        printf("  %-26s %6lu ms  tx %5lu  rx %5lu\n", names[i], prof->state[i].time_ms,
+               prof->state[i].tx_bytes, prof->state[i].rx_bytes);
+    }
+}
 #endif
 
 uint8_t HT_MQTT_Connect(MQTTClient *mqtt_client, Network *mqtt_network, char *addr, int32_t port, uint32_t send_timeout, uint32_t rcv_timeout, char *clientID, 
                                         char *username, char *password, uint8_t mqtt_version, uint32_t keep_alive_interval, uint8_t *sendbuf, 
                                         uint32_t sendbuf_size, uint8_t *readbuf, uint32_t readbuf_size) {
+    TickType_t start;
+    int32_t ret;
 
+    memset(&connectProfile, 0, sizeof(connectProfile));
 
 #if  MQTT_TLS_ENABLE == 1
-    mqtt_client_ctx.caCertLen = 0;
     mqtt_client_ctx.port = port;
     mqtt_client_ctx.host = addr;
     mqtt_client_ctx.timeout_ms = MQTT_GENERAL_TIMEOUT;
@@ -55,16 +192,48 @@ uint8_t HT_MQTT_Connect(MQTTClient *mqtt_client, Network *mqtt_network, char *ad
 
 #if  MQTT_TLS_ENABLE == 1
 
-    printf("Starting TLS handshake...\n");
+    HT_UsrNvMem_t *nvmem = HT_UsrNvMem_Get();
+    HT_TlsSessionRetained_t *retained = (nvmem != NULL) ? &nvmem->tls_session : NULL;
 
-    if(HT_MQTT_TLSConnect(&mqtt_client_ctx, mqtt_network) != 0) {
+    HT_MQTT_TLSSelectAuth();
+    HT_MQTT_TLSSessionLoad(retained, addr, port);
+    printf("Starting TLS%s handshake%s...\n", mqtt_client_ctx.psk ? "-PSK" : "", mqtt_client_ctx.session ? " (resumption)" : "");
+
+    start = xTaskGetTickCount();
+    ret = HT_MQTT_TLSConnect(&mqtt_client_ctx, mqtt_network);
+
+    // O perfil do TLS separa o connect TCP do handshake
+    connectProfile.net_ms = HT_MQTT_TLSGetProfile()->tcp_ms;
+    connectProfile.tls_ms = HT_MQTT_ELAPSED_MS(start);
+    connectProfile.tls_ms -= (connectProfile.tls_ms > connectProfile.net_ms) ? connectProfile.net_ms : connectProfile.tls_ms;
+
+    if(ret != 0) {
         printf("TLS Connection Error!\n");
+        HT_MQTT_TLSPrintProfile();
         return 1;
     }
 
+    HT_MQTT_TLSPrintProfile();
+
+    printf("TLS %s\n", mqtt_client_ctx.sessionResumed ? "session resumed" : "full handshake");
+    HT_MQTT_TLSSessionStore(retained, addr, port);
+
+#if HT_MQTT_TLS_ZERO_COPY == 1
+    // Os pacotes sao montados direto no registro TLS de saida, sendbuf nao e usado
+    size_t tls_out_len;
+    sendbuf = HT_MQTT_TLSSendBuffer(&tls_out_len);
+    sendbuf_size = (uint32_t)tls_out_len;
+    if (sendbuf == NULL)
+        return 1;
+#endif
+
     MQTTClientInit(mqtt_client, mqtt_network, MQTT_GENERAL_TIMEOUT, (unsigned char *)sendbuf, sendbuf_size, (unsigned char *)readbuf, readbuf_size);
 
-    if ((MQTTConnect(mqtt_client, &connectData)) != 0) {
+    start = xTaskGetTickCount();
+    ret = MQTTConnect(mqtt_client, &connectData);
+    connectProfile.mqtt_ms = HT_MQTT_ELAPSED_MS(start);
+
+    if (ret != 0) {
         mqtt_client->ping_outstanding = 1;
         return 1;
     } else {
@@ -82,14 +251,22 @@ uint8_t HT_MQTT_Connect(MQTTClient *mqtt_client, Network *mqtt_network, char *ad
 
     } else {
         
-        if ((NetworkConnect(mqtt_network, addr, port)) != 0) {
+        start = xTaskGetTickCount();
+        ret = NetworkConnect(mqtt_network, addr, port);
+        connectProfile.net_ms = HT_MQTT_ELAPSED_MS(start);
+
+        if (ret != 0) {
             mqtt_client->keepAliveInterval = connectData.keepAliveInterval;
             mqtt_client->ping_outstanding = 1;
             
             return 1;
 
         } else {
-            if ((MQTTConnect(mqtt_client, &connectData)) != 0) {
+            start = xTaskGetTickCount();
+            ret = MQTTConnect(mqtt_client, &connectData);
+            connectProfile.mqtt_ms = HT_MQTT_ELAPSED_MS(start);
+
+            if (ret != 0) {
                 mqtt_client->ping_outstanding = 1;
                 return 1;
     
@@ -98,11 +275,13 @@ uint8_t HT_MQTT_Connect(MQTTClient *mqtt_client, Network *mqtt_network, char *ad
             }
         }
 
+#if HT_MQTT_RECV_TASK_ENABLE == 1
         if(mqtt_client->ping_outstanding == 0) {
             if ((MQTTStartRECVTask(mqtt_client)) != SUCCESS){
                 return 1;
             }
         }
+#endif
     }
 
 #endif
@@ -110,7 +289,11 @@ uint8_t HT_MQTT_Connect(MQTTClient *mqtt_client, Network *mqtt_network, char *ad
     return 0;
 }
 
-void HT_MQTT_Publish(MQTTClient *mqtt_client, char *topic, uint8_t *payload, uint32_t len, enum QoS qos, uint8_t retained, uint16_t id, uint8_t dup) {
+const HT_MQTT_ConnectProfile *HT_MQTT_GetConnectProfile(void) {
+    return &connectProfile;
+}
+
+int HT_MQTT_Publish(MQTTClient *mqtt_client, char *topic, uint8_t *payload, uint32_t len, enum QoS qos, uint8_t retained, uint16_t id, uint8_t dup) {
     MQTTMessage message;
 
     message.qos = qos;
@@ -120,22 +303,20 @@ void HT_MQTT_Publish(MQTTClient *mqtt_client, char *topic, uint8_t *payload, uin
     message.payload = payload;
     message.payloadlen = len;
 
-    MQTTPublish(mqtt_client, topic, &message);
+    return MQTTPublish(mqtt_client, topic, &message);
 }
 
 void HT_MQTT_SubscribeCallback(MessageData *msg) {
     // Criar copias terminadas em null das strings para evitar problemas
-    char *payload_str = malloc(msg->message->payloadlen + 1);
-    char *topic_str = malloc(msg->topicName->lenstring.len + 1);
+    char *payload_str = subPayloadStr;
+    char *topic_str = subTopicStr;
     
-    if (!payload_str || !topic_str) {
-        printf("Erro de alocacao de memoria no callback MQTT\n");
-        if (payload_str) free(payload_str);
-        if (topic_str) free(topic_str);
+    if (msg->message->payloadlen > HT_MQTT_SUB_PAYLOAD_MAX_LEN || msg->topicName->lenstring.len > HT_MQTT_SUB_TOPIC_MAX_LEN) {
+        printf("Mensagem MQTT maior que os buffers do callback, descartada\n");
         return;
     }
     
-    // Copiar o payload e o topico para as strings alocadas
+    // Copiar o payload e o topico para os buffers estaticos
     memcpy(payload_str, msg->message->payload, msg->message->payloadlen);
     payload_str[msg->message->payloadlen] = '\0';
     
@@ -144,7 +325,7 @@ void HT_MQTT_SubscribeCallback(MessageData *msg) {
     
     printf("\n=== MENSAGEM MQTT RECEBIDA ===\n");
     printf("Topico: '%s'\n", topic_str);
-    printf("Tamanho: %d bytes\n", msg->message->payloadlen);
+    printf("Tamanho: %u bytes\n", (unsigned)msg->message->payloadlen);
     printf("Payload: '%s'\n", payload_str);
     
     // Verificar se é o topico de intervalo - usando strcmp para comparacao exata
@@ -189,7 +370,7 @@ void HT_MQTT_SubscribeCallback(MessageData *msg) {
                 if (endptr != number_buffer && (*endptr == '\0' || *endptr == '.') && interval_value > 0) {
                     // Converter segundos para milissegundos
                     uint32_t new_interval_ms = (uint32_t)(interval_value * 1000);
-                    printf("SEGUNDA TENTATIVA - NOVO INTERVALO: %lu ms (%ld segundos)\n", 
+                    printf("SEGUNDA TENTATIVA - NOVO INTERVALO: %" PRIu32 " ms (%ld segundos)\n", 
                            new_interval_ms, interval_value);
                     
                     // Atualizar o intervalo de sono usando a funcao direta
@@ -213,10 +394,6 @@ void HT_MQTT_SubscribeCallback(MessageData *msg) {
     subscribe_callback = 1;
     HT_FSM_SetSubscribeBuff((uint8_t *)payload_str, (uint8_t)strlen(payload_str));
     
-    // Limpar a memoria alocada
-    free(payload_str);
-    free(topic_str);
-    
     printf("=== FIM DO PROCESSAMENTO MQTT ===\n\n");
 }
 
@@ -0,0 +1,184 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_NetProvision.h"
+#include "HT_CIoT.h"
+#include "main.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    uint32_t magic;
+    uint32_t factory_hash;                              // Perfil de fabrica do firmware que gravou o arquivo
+    HT_NetProfile_t profile;
+    uint8_t applied_pdn_type;                           // Tipo de PDN gravado na pilha, 0 se desconhecido
+    uint8_t crc;
+} HT_NetProfileFile_t;
+
+static HT_NetProfileFile_t provCache;
+static bool provLoaded = false;
+
+static void HT_PROV_Factory(HT_NetProfile_t *profile) {
+    memset(profile, 0, sizeof(HT_NetProfile_t));
+    profile->network_mode = HT_PROV_NETWORK_MODE;
+    profile->band_num = 1;
+    profile->bands[0] = HT_PROV_BAND;
+    profile->cid = HT_PROV_CID;
+#if HT_CIOT_ENABLE == 1
+    profile->pdn_type = CMI_PS_PDN_TYPE_NON_IP;
+#else
+    profile->pdn_type = CMI_PS_PDN_TYPE_IP_V4V6;
+#endif
+    strncpy(profile->apn, HT_PROV_APN, HT_PROV_APN_MAX_LEN);
+}
+
+static uint32_t HT_PROV_Hash(const HT_NetProfile_t *profile) {
+    const uint8_t *p = (const uint8_t *)profile;
+    uint32_t hash = 2166136261u;
+
+    // FNV-1a: detecta um firmware com outro perfil de fabrica
+    for (size_t i = 0; i < sizeof(HT_NetProfile_t); i++)
+        hash = (hash ^ p[i]) * 16777619u;
+
+    return hash;
+}
+
+static uint8_t HT_PROV_Crc(const HT_NetProfileFile_t *file) {
+    return OsaCalcCrcValue((const UINT8 *)file, offsetof(HT_NetProfileFile_t, crc));
+}
+
+static bool HT_PROV_ReadFile(HT_NetProfileFile_t *file) {
+    OSAFILE fp = OsaFopen(HT_PROV_FILE_NAME, "rb");
+    bool ok;
+
+    if (fp == NULL)
+        return false;
+
+    ok = OsaFread(file, sizeof(HT_NetProfileFile_t), 1, fp) == 1 &&
+         file->magic == HT_PROV_MAGIC && file->crc == HT_PROV_Crc(file) &&
+         file->profile.band_num <= HT_PROV_MAX_BANDS;
+    OsaFclose(fp);
+
+    return ok;
+}
+
+static bool HT_PROV_WriteFile(HT_NetProfileFile_t *file) {
+    OSAFILE fp;
+    bool ok;
+
+    file->magic = HT_PROV_MAGIC;
+    file->crc = HT_PROV_Crc(file);
+
+    fp = OsaFopen(HT_PROV_FILE_NAME, "wb");
+    ok = fp != NULL && OsaFwrite(file, sizeof(HT_NetProfileFile_t), 1, fp) == 1;
+    if (fp != NULL)
+        OsaFclose(fp);
+
+    if (!ok)
+        printf("Falha ao gravar %s\n", HT_PROV_FILE_NAME);
+
+    return ok;
+}
+
+static void HT_PROV_Load(void) {
+    HT_NetProfile_t factory;
+    uint32_t factory_hash;
+
+    if (provLoaded)
+        return;
+    provLoaded = true;
+
+    HT_PROV_Factory(&factory);
+    factory_hash = HT_PROV_Hash(&factory);
+
+    if (HT_PROV_ReadFile(&provCache) && provCache.factory_hash == factory_hash)
+        return;
+
+    // Sem arquivo, ou gravado por um firmware com outro perfil de fabrica
+    printf("Gravando perfil de rede de fabrica\n");
+    memset(&provCache, 0, sizeof(provCache));
+    provCache.factory_hash = factory_hash;
+    provCache.profile = factory;
+    HT_PROV_WriteFile(&provCache);
+}
+
+bool HT_NetProvision_Apply(void) {
+    const HT_NetProfile_t *profile;
+    INT8 networkMode = -1;
+    UINT8 bandNum = 0;
+    UINT8 bands[HT_PROV_MAX_BANDS] = {0};
+    UINT8 apn[HT_PROV_APN_MAX_LEN + 1] = {0};
+    PsAPNSetting apnSetting;
+    UINT8 cid = 0;
+    bool changed = false;
+
+    HT_PROV_Load();
+    profile = &provCache.profile;
+
+    if (appGetBandModeSync(&networkMode, &bandNum, bands) != CMS_RET_SUCC || networkMode != profile->network_mode ||
+            bandNum != profile->band_num || memcmp(bands, profile->bands, bandNum) != 0) {
+        printf("Configurando banda %d\n", profile->bands[0]);
+        if (appSetBandModeSync(profile->network_mode, profile->band_num, (UINT8 *)profile->bands) == CMS_RET_SUCC)
+            changed = true;
+    }
+
+    // O tipo de PDN nao e lido de volta: vale o ultimo gravado por este modulo
+    if (appGetAPNSettingSync(profile->cid, apn) != CMS_RET_SUCC || strcmp((char *)apn, profile->apn) != 0 ||
+            provCache.applied_pdn_type != profile->pdn_type) {
+        memset(&apnSetting, 0, sizeof(apnSetting));
+        apnSetting.cid = profile->cid;
+        apnSetting.apnLength = strlen(profile->apn);
+        memcpy(apnSetting.apnStr, profile->apn, apnSetting.apnLength);
+        apnSetting.pdnType = profile->pdn_type;
+
+        printf("Configurando APN '%s'\n", profile->apn);
+        if (appSetAPNSettingSync(&apnSetting, &cid) == CMS_RET_SUCC) {
+            changed = true;
+            if (provCache.applied_pdn_type != profile->pdn_type) {
+                provCache.applied_pdn_type = profile->pdn_type;
+                HT_PROV_WriteFile(&provCache);
+            }
+        }
+    }
+
+    if (!changed)
+        printf("Perfil de rede inalterado\n");
+
+    return changed;
+}
+
+bool HT_NetProvision_Store(const HT_NetProfile_t *profile) {
+    HT_NetProfileFile_t file;
+
+    if (profile->band_num == 0 || profile->band_num > HT_PROV_MAX_BANDS ||
+            memchr(profile->apn, '\0', sizeof(profile->apn)) == NULL)
+        return false;
+
+    HT_PROV_Load();
+
+    // Evita regravar a flash quando o perfil nao mudou
+    if (memcmp(&provCache.profile, profile, sizeof(HT_NetProfile_t)) == 0)
+        return true;
+
+    file = provCache;
+    file.profile = *profile;
+    if (!HT_PROV_WriteFile(&file))
+        return false;
+
+    provCache = file;
+    return true;
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,169 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_Policy.h"
+#include "main.h"
+#include "batmon_qcx212.h"
+#include "senseclima.h"
+#include "HT_Samples.h"
+#include <stdio.h>
+
+static const uint8_t policyStretch[HT_POLICY_LEVEL_MAX + 1] = HT_POLICY_STRETCH;
+static const uint8_t policyBatch[HT_POLICY_LEVEL_MAX + 1] = HT_POLICY_BATCH;
+
+// Radio lido neste despertar; o valor retido pode ser de outra celula
+static bool policyRadioFresh = false;
+
+static uint8_t HT_Policy_CurrentLevel(void) {
+    HT_UsrNvMem_t *nv = HT_UsrNvMem_Get();
+
+    if (nv == NULL || nv->policy.level > HT_POLICY_LEVEL_MAX)
+        return 0;
+
+    return nv->policy.level;
+}
+
+static uint8_t HT_Policy_BatteryScore(uint16_t vbat_mv) {
+    if (vbat_mv == 0 || vbat_mv >= HT_POLICY_VBAT_GOOD_MV)
+        return 0;
+    if (vbat_mv >= HT_POLICY_VBAT_LOW_MV)
+        return 1;
+    if (vbat_mv >= HT_POLICY_VBAT_CRITICAL_MV)
+        return 2;
+
+    return 3;
+}
+
+static uint8_t HT_Policy_RadioScore(const HT_PolicyRetained_t *policy) {
+    uint8_t score;
+
+    if (!policy->radio_valid)
+        return 0;
+
+    score = policy->ce_level > 2 ? 2 : policy->ce_level;
+    if (score == 0 && (policy->rsrp_dbm < HT_POLICY_RSRP_WEAK_DBM || policy->snr_db < HT_POLICY_SNR_WEAK_DB))
+        score = 1;
+
+    return score;
+}
+
+bool HT_Policy_SampleRadio(HT_PolicyRadio_t *radio) {
+    UINT8 csq = 0;
+    INT8 snr = 0, rsrp = 0;
+
+    if (appGetSignalInfoSync(&csq, &snr, &rsrp) != CMS_RET_SUCC)
+        return false;
+
+    // Sem celula medida a pilha devolve CMI_MM_NOT_DETECT_RSRP; o SNR so vale de -30 a 30 dB
+    if (rsrp == CMI_MM_NOT_DETECT_RSRP || rsrp < 0 || rsrp > 97 || snr < -30 || snr > 30)
+        return false;
+
+    // RSRP na escala do +CESQ: 0 e abaixo de -140 dBm, 97 e -44 dBm ou mais
+    radio->rsrp_dbm = (int16_t)rsrp - 141;
+    radio->snr_db = snr;
+    radio->ce_level = appGetCELevelSync();
+
+    return true;
+}
+
+void HT_Policy_Update(void) {
+    HT_UsrNvMem_t *nv = HT_UsrNvMem_Get();
+    HT_PolicyRetained_t *policy;
+    HT_PolicyRadio_t radio;
+    int32_t raw = 0;
+    int32_t vbat_mv;
+    uint32_t target;
+
+    if (nv == NULL)
+        return;
+
+    policy = &nv->policy;
+    if (policy->level > HT_POLICY_LEVEL_MAX)
+        policy->level = 0;
+
+    vbat_mv = BatMon_SampleVbatVoltagePolling(HT_POLICY_VBAT_TIMEOUT_MS, &raw);
+    if (vbat_mv > 0 && vbat_mv <= UINT16_MAX)
+        policy->vbat_mv = (uint16_t)vbat_mv;
+
+    // Sem resposta da pilha ou sem celula medida: mantem as condicoes de radio do despertar anterior
+    if (HT_Policy_SampleRadio(&radio)) {
+        policy->rsrp_dbm = radio.rsrp_dbm;
+        policy->snr_db = radio.snr_db;
+        policy->ce_level = radio.ce_level;
+        policy->radio_valid = 1;
+        policyRadioFresh = true;
+    }
+
+    target = HT_Policy_BatteryScore(policy->vbat_mv) + HT_Policy_RadioScore(policy);
+    if (nv->energy.avg_wake_uc > HT_POLICY_WAKE_UC_HIGH)
+        target++;
+    if (target > HT_POLICY_LEVEL_MAX)
+        target = HT_POLICY_LEVEL_MAX;
+
+    // Piora aplicada na hora, melhora um nivel por despertar para nao oscilar
+    if (target < policy->level)
+        policy->level--;
+    else
+        policy->level = (uint8_t)target;
+
+    HT_UsrNvMem_Update();
+
+    printf("Politica: VBAT=%u mV, RSRP=%d dBm, SNR=%d dB, CE=%u, carga media=%lu uC -> nivel %u\n",
+           policy->vbat_mv, policy->rsrp_dbm, policy->snr_db, policy->ce_level, nv->energy.avg_wake_uc, policy->level);
+    printf("Intervalo efetivo: %lu ms, %u leituras por envio\n", HT_Policy_SleepInterval(), HT_Policy_SamplesPerUpload());
+}
+
+bool HT_Policy_DeferUpload(void) {
+    HT_UsrNvMem_t *nv = HT_UsrNvMem_Get();
+    uint8_t kept = HT_Samples_Count();
+    uint64_t age_ms = (uint64_t)kept * HT_Policy_SleepInterval();
+
+    if (nv == NULL || !policyRadioFresh)
+        return false;
+
+    if (nv->policy.ce_level < HT_POLICY_GATE_CE_LEVEL && nv->policy.rsrp_dbm >= HT_POLICY_GATE_RSRP_DBM &&
+            nv->policy.snr_db >= HT_POLICY_GATE_SNR_DB)
+        return false;
+
+    // Leituras pedidas por botao, lote cheio ou leitura antiga demais: envia mesmo assim
+    if (slpManGetWakeupSrc() != WAKEUP_FROM_RTC || kept + 1 >= HT_SAMPLES_MAX || age_ms >= HT_POLICY_GATE_MAX_AGE_MS) {
+        printf("Cobertura ruim, mas o envio nao pode esperar (%u leituras, a mais antiga ha %lu s)\n",
+               kept, (uint32_t)(age_ms / 1000));
+        return false;
+    }
+
+    printf("Envio adiado: CE=%u, RSRP=%d dBm, SNR=%d dB (%u leituras guardadas)\n",
+           nv->policy.ce_level, nv->policy.rsrp_dbm, nv->policy.snr_db, kept);
+    return true;
+}
+
+uint32_t HT_Policy_SleepInterval(void) {
+    uint32_t base = SenseClima_GetSleepInterval();
+    uint64_t interval = (uint64_t)base * policyStretch[HT_Policy_CurrentLevel()];
+
+    // O limite so restringe o alongamento, nunca o intervalo configurado
+    if (interval > HT_POLICY_MAX_INTERVAL_MS)
+        interval = base > HT_POLICY_MAX_INTERVAL_MS ? base : HT_POLICY_MAX_INTERVAL_MS;
+
+    return (uint32_t)interval;
+}
+
+uint8_t HT_Policy_SamplesPerUpload(void) {
+    uint8_t batch = policyBatch[HT_Policy_CurrentLevel()];
+
+    return batch == 0 ? 1 : batch;
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,134 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_Samples.h"
+#include "HT_MQTT_Api.h"
+#include "HT_Policy.h"
+#include "main.h"
+#include <stdio.h>
+#include <string.h>
+#include <stdlib.h>
+
+// {"seq":65535,"interval_s":4294967295,"temperature":[...],"humidity":[...]}, ate 8 caracteres por leitura
+static char samplesMsg[80 + HT_SAMPLES_MAX * 2 * 8];
+
+static HT_SamplesRetained_t *HT_Samples_Retained(void) {
+    HT_UsrNvMem_t *nv = HT_UsrNvMem_Get();
+
+    if (nv == NULL)
+        return NULL;
+
+    if (nv->samples.count > HT_SAMPLES_MAX)
+        nv->samples.count = 0;
+
+    return &nv->samples;
+}
+
+static int HT_Samples_PutTenths(char *buf, size_t size, bool first, bool valid, int32_t v_x10) {
+    const char *sep = first ? "" : ",";
+
+    if (!valid)
+        return snprintf(buf, size, "%snull", sep);
+
+    return snprintf(buf, size, "%s%s%ld.%ld", sep, v_x10 < 0 ? "-" : "", labs(v_x10) / 10, labs(v_x10) % 10);
+}
+
+void HT_Samples_Add(bool valid, float temperature, float humidity) {
+    HT_SamplesRetained_t *batch = HT_Samples_Retained();
+
+    if (batch == NULL)
+        return;
+
+    // Lote cheio: descarta a leitura mais antiga
+    if (batch->count == HT_SAMPLES_MAX) {
+        memmove(&batch->temp_x10[0], &batch->temp_x10[1], (HT_SAMPLES_MAX - 1) * sizeof(batch->temp_x10[0]));
+        memmove(&batch->hum_x10[0], &batch->hum_x10[1], (HT_SAMPLES_MAX - 1) * sizeof(batch->hum_x10[0]));
+        batch->count--;
+    }
+
+    batch->temp_x10[batch->count] = valid ? (int16_t)(temperature * 10) : HT_SAMPLES_TEMP_INVALID;
+    batch->hum_x10[batch->count] = valid ? (uint16_t)(humidity * 10) : HT_SAMPLES_HUM_INVALID;
+    batch->count++;
+    HT_UsrNvMem_Update();
+}
+
+uint8_t HT_Samples_Count(void) {
+    HT_SamplesRetained_t *batch = HT_Samples_Retained();
+
+    return batch != NULL ? batch->count : 0;
+}
+
+uint8_t HT_Samples_PerUpload(void) {
+    uint8_t samples = HT_Policy_SamplesPerUpload();
+
+    // A politica so aumenta o lote configurado
+    if (samples < HT_SAMPLES_UPLOAD_MIN)
+        samples = HT_SAMPLES_UPLOAD_MIN;
+    if (samples > HT_SAMPLES_MAX)
+        samples = HT_SAMPLES_MAX;
+
+    return samples;
+}
+
+const HT_SamplesRetained_t *HT_Samples_Get(void) {
+    return HT_Samples_Retained();
+}
+
+void HT_Samples_Uploaded(void) {
+    HT_SamplesRetained_t *batch = HT_Samples_Retained();
+
+    if (batch == NULL)
+        return;
+
+    batch->seq++;
+    batch->count = 0;
+    HT_UsrNvMem_Update();
+}
+
+bool HT_Samples_Publish(MQTTClient *client) {
+    const HT_SamplesRetained_t *batch = HT_Samples_Get();
+    int len;
+
+    if (batch == NULL || batch->count == 0)
+        return true;
+    if (!client->isconnected)
+        return false;
+
+    len = snprintf(samplesMsg, sizeof(samplesMsg), "{\"seq\":%u,\"interval_s\":%lu,\"temperature\":[",
+                   batch->seq, HT_Policy_SleepInterval() / 1000);
+    for (uint8_t i = 0; i < batch->count && len > 0 && len < (int)sizeof(samplesMsg); i++)
+        len += HT_Samples_PutTenths(&samplesMsg[len], sizeof(samplesMsg) - len, i == 0,
+                                    batch->temp_x10[i] != HT_SAMPLES_TEMP_INVALID, batch->temp_x10[i]);
+    if (len > 0 && len < (int)sizeof(samplesMsg))
+        len += snprintf(&samplesMsg[len], sizeof(samplesMsg) - len, "],\"humidity\":[");
+    for (uint8_t i = 0; i < batch->count && len > 0 && len < (int)sizeof(samplesMsg); i++)
+        len += HT_Samples_PutTenths(&samplesMsg[len], sizeof(samplesMsg) - len, i == 0,
+                                    batch->hum_x10[i] != HT_SAMPLES_HUM_INVALID, batch->hum_x10[i]);
+    if (len > 0 && len < (int)sizeof(samplesMsg))
+        len += snprintf(&samplesMsg[len], sizeof(samplesMsg) - len, "]}");
+    if (len <= 0 || len >= (int)sizeof(samplesMsg))
+        return false;
+
+    printf("Publicando %u leituras guardadas (seq %u)\n", batch->count, batch->seq);
+    if (HT_MQTT_Publish(client, HT_SAMPLES_BATCH_TOPIC, (uint8_t *)samplesMsg, (uint32_t)len, QOS1, 0, 0, 0) != SUCCESS) {
+        printf("Lote sem confirmacao do broker, mantido para o proximo envio\n");
+        return false;
+    }
+
+    HT_Samples_Uploaded();
+    return true;
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
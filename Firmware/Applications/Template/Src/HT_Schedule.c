@@ -0,0 +1,126 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_Schedule.h"
+#include "HT_Policy.h"
+#include "HT_Samples.h"
+#include <stdio.h>
+
+#define HT_SCHEDULE_TIMER(task) ((slpManTimerID_e)(DEEPSLP_TIMER_ID0 + (task)))
+#define HT_SCHEDULE_BIT(task)   (1U << (task))
+
+static const char *const scheduleName[HT_SCHEDULE_COUNT] = {
+    "leitura", "envio", "saude",
+};
+
+static uint8_t scheduleDue = 0;
+static uint8_t scheduleDone = 0;
+
+void HT_Schedule_Begin(void) {
+    HT_UsrNvMem_t *nv = HT_UsrNvMem_Get();
+    uint8_t armed = nv != NULL ? nv->schedule.armed : 0;
+
+    // O temporizador que ja nao conta venceu; apos power on nenhum conta
+    for (uint8_t task = 0; task < HT_SCHEDULE_COUNT; task++) {
+        if (!(armed & HT_SCHEDULE_BIT(task)) || !slpManDeepSlpTimerIsRunning(HT_SCHEDULE_TIMER(task)))
+            scheduleDue |= HT_SCHEDULE_BIT(task);
+    }
+
+    printf("Prazos vencidos:");
+    for (uint8_t task = 0; task < HT_SCHEDULE_COUNT; task++) {
+        if (scheduleDue & HT_SCHEDULE_BIT(task))
+            printf(" %s", scheduleName[task]);
+    }
+    printf(scheduleDue ? "\n" : " nenhum\n");
+}
+
+bool HT_Schedule_IsDue(HT_ScheduleTask task) {
+    return (scheduleDue & HT_SCHEDULE_BIT(task)) != 0;
+}
+
+bool HT_Schedule_NeedsNetwork(void) {
+    if (HT_Schedule_IsDue(HT_SCHEDULE_UPLOAD) || HT_Schedule_IsDue(HT_SCHEDULE_HEALTH))
+        return true;
+
+    // A leitura deste despertar fecharia o lote
+    return HT_Schedule_IsDue(HT_SCHEDULE_SAMPLE) && HT_Samples_Count() + 1 >= HT_Samples_PerUpload();
+}
+
+void HT_Schedule_Done(HT_ScheduleTask task) {
+    scheduleDone |= HT_SCHEDULE_BIT(task);
+}
+
+uint32_t HT_Schedule_Period(HT_ScheduleTask task) {
+    uint64_t period;
+
+    switch (task) {
+        case HT_SCHEDULE_SAMPLE:
+            period = HT_Policy_SleepInterval();
+            break;
+        case HT_SCHEDULE_UPLOAD:
+            period = (uint64_t)HT_Policy_SleepInterval() * HT_Samples_PerUpload();
+            break;
+        default:
+            period = HT_SCHEDULE_HEALTH_PERIOD_MS;
+            break;
+    }
+
+    return period > HT_SCHEDULE_MAX_PERIOD_MS ? HT_SCHEDULE_MAX_PERIOD_MS : (uint32_t)period;
+}
+
+uint32_t HT_Schedule_Arm(void) {
+    HT_UsrNvMem_t *nv = HT_UsrNvMem_Get();
+    uint32_t next_ms = HT_SCHEDULE_MAX_PERIOD_MS;
+    uint8_t next = HT_SCHEDULE_SAMPLE;
+
+    for (uint8_t task = 0; task < HT_SCHEDULE_COUNT; task++) {
+        slpManTimerID_e timer = HT_SCHEDULE_TIMER(task);
+        uint32_t period = HT_Schedule_Period((HT_ScheduleTask)task);
+        uint32_t remain = slpManDeepSlpTimerIsRunning(timer) ? slpManDeepSlpTimerRemainMs(timer) : 0;
+        uint32_t armed_period = nv != NULL ? nv->schedule.period_ms[task] : period;
+
+        if (remain == 0 || (scheduleDone & HT_SCHEDULE_BIT(task))) {
+            slpManDeepSlpTimerStart(timer, period);
+            remain = period;
+        } else if (armed_period != period) {
+            // O periodo mudou (intervalo ou politica): o novo conta desde o inicio do prazo em curso
+            uint32_t elapsed = armed_period > remain ? armed_period - remain : 0;
+
+            remain = period > elapsed + HT_SCHEDULE_MIN_REMAIN_MS ? period - elapsed : HT_SCHEDULE_MIN_REMAIN_MS;
+            slpManDeepSlpTimerStart(timer, remain);
+        }
+
+        if (remain < next_ms) {
+            next_ms = remain;
+            next = task;
+        }
+
+        if (nv != NULL)
+            nv->schedule.period_ms[task] = period;
+    }
+
+    if (nv != NULL) {
+        nv->schedule.armed = (1U << HT_SCHEDULE_COUNT) - 1;
+        HT_UsrNvMem_Update();
+    }
+
+    scheduleDue = 0;
+    scheduleDone = 0;
+    printf("Proximo despertar em %lu ms (%s)\n", next_ms, scheduleName[next]);
+
+    return next_ms;
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -18,6 +18,35 @@
 #include "htnb32lxxx_hal_usart.h"
 #include "debug_log.h"
 #include "ps_lib_api.h"
+#include "HT_UsrNvMem.h"
+#include "HT_Energy.h"
+#include "HT_Schedule.h"
+#include "os_exception.h"
+#include "semphr.h"
+#include <stdio.h>
+
+#define HT_SLEEP_ELAPSED_MS(start) ((uint32_t)((xTaskGetTickCount() - (start)) * portTICK_PERIOD_MS))
+
+static bool psmGranted = false;
+static int8_t psmResumed = -1;
+
+// Votos da aplicacao, liberados e citados no diagnostico da entrada em hibernacao
+static struct {
+    uint8_t handle;
+    uint8_t state;
+    bool held;
+} sleepHolds[HT_SLEEP_MAX_HOLDS];
+static uint8_t sleepHoldCount = 0;
+
+// Eventos da pilha durante a espera pela hibernacao
+static StaticSemaphore_t sleepEventBuf;
+static SemaphoreHandle_t sleepEvent = NULL;
+static volatile uint16_t sleepLastEvent = 0;
+static volatile TickType_t sleepLastEventTick = 0;
+
+static const char *const sleepDrvName[SLP_VOTE_MAX_NUM] = {
+    "USART", "I2C", "SPI", "ADC", "DMA", "TIMER",
+};
 
 // Callbacks para modo de sono
 static void beforeHibernateCb(void *pdata, slpManLpState state) {
@@ -28,17 +57,217 @@ static void afterHibernateCb(void *pdata, slpManLpState state) {
     printf("[Callback] Sistema acordou da hibernacao\n");
 }
 
-void HT_Sleep_EnterSleep(slpManSlpState_t state, uint32_t sleep_ms) {
+void HT_Sleep_ConfigurePsm(uint32_t interval_ms) {
+    HT_UsrNvMem_t *nv = HT_UsrNvMem_Get();
+    uint8_t psmMode = 0;
+    uint32_t tauTime = 0, activeTime = 0;
+
+#if HT_SLEEP_USE_PSM == 1
+    uint32_t tau_s = interval_ms / 1000 + HT_SLEEP_PSM_TAU_MARGIN_S;
+
+    // Reenviar os mesmos temporizadores forcaria um TAU a cada despertar
+    if (nv == NULL || nv->psm.req_tau_s != tau_s || nv->psm.req_active_s != HT_SLEEP_PSM_ACTIVE_TIME_S) {
+        printf("Solicitando PSM: T3412=%lu s, T3324=%u s\n", tau_s, HT_SLEEP_PSM_ACTIVE_TIME_S);
+        if (appSetPSMSettingSync(1, tau_s, HT_SLEEP_PSM_ACTIVE_TIME_S) == CMS_RET_SUCC && nv != NULL) {
+            nv->psm.req_tau_s = tau_s;
+            nv->psm.req_active_s = HT_SLEEP_PSM_ACTIVE_TIME_S;
+            HT_UsrNvMem_Update();
+        }
+    }
+#else
+    if (nv == NULL || nv->psm.req_tau_s != 0) {
+        appSetPSMSettingSync(0, 0, 0);
+        if (nv != NULL) {
+            nv->psm.req_tau_s = 0;
+            nv->psm.req_active_s = 0;
+            HT_UsrNvMem_Update();
+        }
+    }
+#endif
+
+    // Valores concedidos pela rede
+    appGetPSMSettingSync(&psmMode, &tauTime, &activeTime);
+    psmGranted = (HT_SLEEP_USE_PSM == 1) && psmMode == 1 && tauTime > interval_ms / 1000;
+    printf("Get PSM info mode=%d, TAU=%lu, ActiveTime=%lu\n", psmMode, tauTime, activeTime);
+}
+
+uint8_t HT_Sleep_Hold(const char *name, slpManSlpState_t state) {
+    uint8_t handle = 0xFF;
+
+    if (slpManFindPlatVoteHandle(name, &handle) != RET_TRUE &&
+            slpManApplyPlatVoteHandle(name, &handle) != RET_TRUE)
+        return 0xFF;
+
+    for (uint8_t i = 0; i < sleepHoldCount; i++) {
+        if (sleepHolds[i].handle == handle) {
+            if (!sleepHolds[i].held && slpManPlatVoteDisableSleep(handle, state) == RET_TRUE)
+                sleepHolds[i].held = true;
+            return handle;
+        }
+    }
+
+    if (sleepHoldCount == HT_SLEEP_MAX_HOLDS || slpManPlatVoteDisableSleep(handle, state) != RET_TRUE)
+        return 0xFF;
+
+    sleepHolds[sleepHoldCount].handle = handle;
+    sleepHolds[sleepHoldCount].state = state;
+    sleepHolds[sleepHoldCount].held = true;
+    sleepHoldCount++;
+
+    return handle;
+}
+
+void HT_Sleep_Release(uint8_t handle) {
+    for (uint8_t i = 0; i < sleepHoldCount; i++) {
+        if (sleepHolds[i].handle == handle && sleepHolds[i].held) {
+            slpManPlatVoteEnableSleep(handle, (slpManSlpState_t)sleepHolds[i].state);
+            sleepHolds[i].held = false;
+        }
+    }
+}
+
+void HT_Sleep_StackEvent(uint16_t event_id) {
+    sleepLastEvent = event_id;
+    sleepLastEventTick = xTaskGetTickCount();
+
+    if (sleepEvent != NULL)
+        xSemaphoreGive(sleepEvent);
+}
+
+void HT_Sleep_ReportLastEntry(void) {
+    HT_UsrNvMem_t *nv = HT_UsrNvMem_Get();
+
+    if (nv == NULL || nv->sleep.last_stage == 0)
+        return;
+
+    printf("Ultima hibernacao fora do prazo (%u no total, etapa %u): PMU=%u, votos=0x%08lX, drivers=0x%08lX, evento=0x%04X\n",
+           nv->sleep.entry_failures, nv->sleep.last_stage, nv->sleep.last_pmu_state,
+           nv->sleep.last_hib_bitmap, nv->sleep.last_drv_bitmap, nv->sleep.last_event_id);
+    nv->sleep.last_stage = 0;
+    HT_UsrNvMem_Update();
+}
+
+bool HT_Sleep_PsmResumed(void) {
+    HT_UsrNvMem_t *nv;
+
+    if (psmResumed < 0) {
+        nv = HT_UsrNvMem_Get();
+        psmResumed = nv != NULL && nv->psm.registered && slpManGetWakeupSrc() != WAKEUP_FROM_POR;
+
+        // Vale apenas para este despertar
+        if (nv != NULL && nv->psm.registered) {
+            nv->psm.registered = 0;
+            HT_UsrNvMem_Update();
+        }
+    }
+
+    return psmResumed == 1;
+}
+
+static void HT_Sleep_Diagnose(uint8_t stage) {
+    HT_UsrNvMem_t *nv = HT_UsrNvMem_Get();
+    uint32_t slp1 = 0, slp2 = 0, hib = 0, drv = 0, mask = 0;
+    slpManSlpState_t pmuState = slpManPlatGetSlpState();
+    slpManSlpState_t voteState;
+    uint8_t counter;
+
+    slpManGetPlatBitmap(&slp1, &slp2, &hib);
+    slpManGetDrvBitmap(&drv, &mask);
+    drv &= ~mask;
+
+    printf("\n=== HIBERNACAO BLOQUEADA (etapa %u) ===\n", stage);
+    printf("PMU permite estado %u, votos slp1=0x%08lX slp2=0x%08lX hib=0x%08lX\n", pmuState, slp1, slp2, hib);
+
+    for (uint8_t handle = 0; handle < SLP_PLAT_VOTE_MAX_NUM; handle++) {
+        if (slpManCheckVoteState(handle, &voteState, &counter) != RET_TRUE || voteState == SLP_ACTIVE_STATE || counter == 0)
+            continue;
+        printf("Voto '%.*s' (handle %u): estado %u, contador %u\n", SLP_PLAT_VOTE_INFO_LEN, (char *)slpManGetVoteInfo(handle),
+               handle, voteState, counter);
+    }
+
+    for (uint8_t i = 0; i < SLP_VOTE_MAX_NUM; i++) {
+        if (drv & (1UL << i))
+            printf("Driver ativo: %s\n", sleepDrvName[i]);
+    }
+
+    if (sleepLastEventTick != 0)
+        printf("Ultimo evento da pilha: 0x%04X ha %lu ms\n", sleepLastEvent, HT_SLEEP_ELAPSED_MS(sleepLastEventTick));
+    else
+        printf("Nenhum evento da pilha durante a espera\n");
+
+    if (nv != NULL) {
+        if (stage == 1)
+            nv->sleep.entry_failures++;
+        nv->sleep.last_stage = stage;
+        nv->sleep.last_pmu_state = (uint8_t)pmuState;
+        nv->sleep.last_hib_bitmap = hib;
+        nv->sleep.last_drv_bitmap = drv;
+        nv->sleep.last_event_id = sleepLastEvent;
+        HT_UsrNvMem_Update();
+    }
+}
+
+static void HT_Sleep_WaitUntil(TickType_t start, uint32_t deadline_ms) {
+    uint16_t seen = sleepLastEvent;
+    uint32_t elapsed;
+
+    // O sistema hiberna durante a espera; voltar daqui significa prazo estourado
+    while ((elapsed = HT_SLEEP_ELAPSED_MS(start)) < deadline_ms) {
+        if (xSemaphoreTake(sleepEvent, pdMS_TO_TICKS(deadline_ms - elapsed)) == pdTRUE && sleepLastEvent != seen) {
+            seen = sleepLastEvent;
+            printf("Evento da pilha 0x%04X aos %lu ms\n", seen, HT_SLEEP_ELAPSED_MS(start));
+        }
+    }
+}
+
+static void HT_Sleep_Enter(slpManSlpState_t state, bool online) {
     static uint8_t voteHandle = 0xFF;
-    
+    HT_UsrNvMem_t *nv;
+    uint32_t sleep_ms;
+    uint32_t deadline_ms;
+    TickType_t start;
+
+    HT_Energy_Start(HT_ENERGY_PHASE_SLEEP);
+
     // Garante que todas as mensagens de log pendentes sejam enviadas antes de dormir
     uniLogFlushOut(0);
     
-    printf("\n=== ENTRANDO EM MODO SONO %d POR %lu ms ===\n", state, sleep_ms);
+    printf("\n=== ENTRANDO EM MODO SONO %d ===\n", state);
     
-    // Desativa funcoes de celular e SIM para economizar energia
-    appSetCFUN(0);
+    nv = HT_UsrNvMem_Get();
+
+    if (sleepEvent == NULL)
+        sleepEvent = xSemaphoreCreateBinaryStatic(&sleepEventBuf);
+    sleepLastEventTick = 0;
+
+    if (online) {
+        // O intervalo pode ter mudado durante este despertar
+        HT_Sleep_ConfigurePsm(HT_Schedule_Period(HT_SCHEDULE_UPLOAD));
+    } else {
+        // Sem uso da rede: os temporizadores PSM nao sao reenviados e o registro mantido continua valido
+        psmGranted = HT_Sleep_PsmResumed();
+    }
+
+    if (psmGranted) {
+        // Mantem o registro: o modem entra em PSM ao fim do T3324 e o proximo despertar envia sem novo attach
+        printf("Hibernando em PSM, contexto PDN mantido\n");
+    } else {
+        // Desativa funcoes de celular para economizar energia
+        if (appSetCFUN(0) != CMS_RET_SUCC)
+            printf("CFUN=0 falhou, a pilha pode segurar a hibernacao\n");
+    }
     appSetEcSIMSleepSync(1);
+
+    if (nv != NULL) {
+        nv->psm.registered = psmGranted;
+        HT_UsrNvMem_Update();
+    }
+
+    // Temporizadores 0-6: os prazos longos seguem contando, o mais proximo acorda o sistema
+    sleep_ms = HT_Schedule_Arm();
+
+    // Fecha a contabilidade do despertar antes da gravacao da memoria NV
+    HT_Energy_EndWake(sleep_ms);
     
     // Primeiro, configura o modo de sono
     // Este comando e importante para inicializar o sistema para o sono
@@ -52,20 +281,51 @@ void HT_Sleep_EnterSleep(slpManSlpState_t state, uint32_t sleep_ms) {
     // Registra callbacks para hibernacao
     slpManRegisterUsrdefinedBackupCb(beforeHibernateCb, NULL, SLPMAN_HIBERNATE_STATE);
     slpManRegisterUsrdefinedRestoreCb(afterHibernateCb, NULL, SLPMAN_HIBERNATE_STATE);
+
+    // Libera os votos da aplicacao ainda mantidos
+    for (uint8_t i = 0; i < sleepHoldCount; i++)
+        HT_Sleep_Release(sleepHolds[i].handle);
     
     // Habilita o modo de sono
     slpManPlatVoteEnableSleep(voteHandle, state);
-    
-    // Configura o timer de sono como fonte de wakeup
-    slpManDeepSlpTimerStart(DEEPSLP_TIMER_ID7, sleep_ms);
-    
-    // Espera passiva - o sistema deve entrar em sono automaticamente
-    // Esta e a abordagem usada no exemplo de referencia
-    while (1) {
-        printf("Hibernando...\n");
-        osDelay(2000);  // apos o tempo, sistema acorda e mensagens sao exibidas
+
+    // Em PSM a pilha so libera a hibernacao depois do T3324
+    start = xTaskGetTickCount();
+    deadline_ms = HT_SLEEP_ENTRY_MARGIN_MS + (psmGranted ? HT_SLEEP_PSM_ACTIVE_TIME_S * 1000 : 0);
+    HT_Sleep_WaitUntil(start, deadline_ms);
+
+    // Prazo estourado: desliga o radio e forca os votos conhecidos
+    HT_Sleep_Diagnose(1);
+    if (psmGranted) {
+        appSetCFUN(0);
+        if (nv != NULL) {
+            nv->psm.registered = 0;
+            HT_UsrNvMem_Update();
+        }
     }
-    
-    // O codigo abaixo nunca sera executado
+    for (uint8_t i = 0; i < sleepHoldCount; i++) {
+        slpManPlatVoteForceEnableSleep(sleepHolds[i].handle, (slpManSlpState_t)sleepHolds[i].state);
+        sleepHolds[i].held = false;
+    }
+    slpManPlatVoteForceEnableSleep(voteHandle, state);
+
+    start = xTaskGetTickCount();
+    HT_Sleep_WaitUntil(start, HT_SLEEP_FALLBACK_MS);
+
+    // Ainda acordado: guarda o diagnostico e reinicia para nao drenar a bateria
+    HT_Sleep_Diagnose(2);
+    HT_UsrNvMem_Flush();
+    printf("Hibernacao nao ocorreu, reiniciando\n");
+    uniLogFlushOut(0);
+    EC_SystemReset();
 }
+
+void HT_Sleep_EnterSleep(slpManSlpState_t state) {
+    HT_Sleep_Enter(state, true);
+}
+
+void HT_Sleep_EnterSleepOffline(slpManSlpState_t state) {
+    HT_Sleep_Enter(state, false);
+}
+
 /************************ HT Micron Semicondutores S.A *****END OF FILE****/
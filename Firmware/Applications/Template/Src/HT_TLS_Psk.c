@@ -0,0 +1,153 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_TLS_Psk.h"
+#include "main.h"
+#include "mbedtls/platform_util.h"
+#include <stdio.h>
+#include <string.h>
+
+typedef struct {
+    uint32_t magic;
+    uint16_t identity_len;
+    uint16_t key_len;
+    uint8_t identity[HT_PSK_IDENTITY_MAX_LEN];
+    uint8_t key[HT_PSK_KEY_MAX_LEN];
+    uint8_t crc;
+} HT_PskFile_t;
+
+static HT_PskFile_t pskCache;
+static bool pskLoaded = false;
+
+static uint8_t HT_PSK_Crc(const HT_PskFile_t *psk) {
+    return OsaCalcCrcValue((const UINT8 *)psk, offsetof(HT_PskFile_t, crc));
+}
+
+static bool HT_PSK_IsValid(const HT_PskFile_t *psk) {
+    return psk->magic == HT_PSK_MAGIC &&
+           psk->identity_len > 0 && psk->identity_len <= HT_PSK_IDENTITY_MAX_LEN &&
+           psk->key_len > 0 && psk->key_len <= HT_PSK_KEY_MAX_LEN &&
+           psk->crc == HT_PSK_Crc(psk);
+}
+
+static bool HT_PSK_ReadFile(HT_PskFile_t *psk) {
+    OSAFILE fp = OsaFopen(HT_PSK_FILE_NAME, "rb");
+    bool ok;
+
+    if (fp == NULL)
+        return false;
+
+    ok = OsaFread(psk, sizeof(HT_PskFile_t), 1, fp) == 1 && HT_PSK_IsValid(psk);
+    OsaFclose(fp);
+
+    return ok;
+}
+
+#if defined(HT_PSK_FACTORY_IDENTITY) && defined(HT_PSK_FACTORY_KEY_HEX)
+static void HT_PSK_FactoryProvision(void) {
+    const char *hex = HT_PSK_FACTORY_KEY_HEX;
+    uint8_t key[HT_PSK_KEY_MAX_LEN];
+    size_t key_len = strlen(hex) / 2;
+
+    if (key_len == 0 || key_len > sizeof(key) || (strlen(hex) & 1)) {
+        printf("PSK de fabrica invalida\n");
+        return;
+    }
+
+    for (size_t i = 0; i < key_len * 2; i++) {
+        char c = hex[i];
+        uint8_t v = (c >= '0' && c <= '9') ? c - '0' : (c >= 'a' && c <= 'f') ? c - 'a' + 10 : (c >= 'A' && c <= 'F') ? c - 'A' + 10 : 0xFF;
+
+        if (v == 0xFF) {
+            printf("PSK de fabrica invalida\n");
+            return;
+        }
+        key[i / 2] = (i & 1) ? (key[i / 2] | v) : (v << 4);
+    }
+
+    printf("Gravando PSK de fabrica para '%s'\n", HT_PSK_FACTORY_IDENTITY);
+    HT_PSK_Provision((const uint8_t *)HT_PSK_FACTORY_IDENTITY, strlen(HT_PSK_FACTORY_IDENTITY), key, key_len);
+    mbedtls_platform_zeroize(key, sizeof(key));
+}
+#endif
+
+bool HT_PSK_Load(const uint8_t **identity, size_t *identity_len, const uint8_t **key, size_t *key_len) {
+    if (!pskLoaded) {
+        pskLoaded = true;
+
+        if (!HT_PSK_ReadFile(&pskCache)) {
+            memset(&pskCache, 0, sizeof(pskCache));
+#if defined(HT_PSK_FACTORY_IDENTITY) && defined(HT_PSK_FACTORY_KEY_HEX)
+            HT_PSK_FactoryProvision();
+#endif
+        }
+    }
+
+    if (!HT_PSK_IsValid(&pskCache))
+        return false;
+
+    *identity = pskCache.identity;
+    *identity_len = pskCache.identity_len;
+    *key = pskCache.key;
+    *key_len = pskCache.key_len;
+
+    return true;
+}
+
+bool HT_PSK_Provision(const uint8_t *identity, size_t identity_len, const uint8_t *key, size_t key_len) {
+    HT_PskFile_t psk;
+    OSAFILE fp;
+    bool ok;
+
+    if (identity_len == 0 || identity_len > HT_PSK_IDENTITY_MAX_LEN || key_len == 0 || key_len > HT_PSK_KEY_MAX_LEN)
+        return false;
+
+    memset(&psk, 0, sizeof(psk));
+    psk.magic = HT_PSK_MAGIC;
+    psk.identity_len = (uint16_t)identity_len;
+    psk.key_len = (uint16_t)key_len;
+    memcpy(psk.identity, identity, identity_len);
+    memcpy(psk.key, key, key_len);
+    psk.crc = HT_PSK_Crc(&psk);
+
+    // Evita regravar a flash quando as credenciais nao mudaram
+    if (pskLoaded && memcmp(&psk, &pskCache, sizeof(psk)) == 0) {
+        mbedtls_platform_zeroize(&psk, sizeof(psk));
+        return true;
+    }
+
+    fp = OsaFopen(HT_PSK_FILE_NAME, "wb");
+    ok = fp != NULL && OsaFwrite(&psk, sizeof(psk), 1, fp) == 1;
+    if (fp != NULL)
+        OsaFclose(fp);
+
+    if (ok) {
+        memcpy(&pskCache, &psk, sizeof(psk));
+        pskLoaded = true;
+    } else {
+        printf("Falha ao gravar %s\n", HT_PSK_FILE_NAME);
+    }
+
+    mbedtls_platform_zeroize(&psk, sizeof(psk));
+    return ok;
+}
+
+void HT_PSK_Erase(void) {
+    OsaFremove(HT_PSK_FILE_NAME);
+    mbedtls_platform_zeroize(&pskCache, sizeof(pskCache));
+    pskLoaded = true;
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -0,0 +1,228 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_TrustStore.h"
+#include "main.h"
+#include "flash_qcx212.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/base64.h"
+#include <stdio.h>
+#include <string.h>
+
+#define HT_TRUST_PEM_LINE_MAX   80                  /**</ Longest base64 line accepted (RFC 7468 uses 64). */
+
+/* Destino dos itens durante o provisionamento: com write = false so calcula offsets e hash */
+typedef struct {
+    uint32_t offset;
+    bool write;
+    mbedtls_sha256_context sha;
+} HT_TrustWriter_t;
+
+static HT_TrustStoreHeader_t trustHdr;
+static uint8_t trustLine[HT_TRUST_PEM_LINE_MAX / 4 * 3];
+static const HT_TrustStoreHeader_t *trustStore = NULL;
+static bool trustChecked = false;
+
+static void HT_TrustStore_Digest(const HT_TrustStoreHeader_t *hdr, const uint8_t *data_hash, uint8_t *digest) {
+    mbedtls_sha256_context sha;
+
+    mbedtls_sha256_init(&sha);
+    mbedtls_sha256_starts_ret(&sha, 0);
+    mbedtls_sha256_update_ret(&sha, (const uint8_t *)hdr->entry, sizeof(hdr->entry));
+    mbedtls_sha256_update_ret(&sha, data_hash, 32);
+    mbedtls_sha256_finish_ret(&sha, digest);
+    mbedtls_sha256_free(&sha);
+}
+
+static const HT_TrustStoreHeader_t *HT_TrustStore_Check(void) {
+    const HT_TrustStoreHeader_t *hdr = (const HT_TrustStoreHeader_t *)HT_TRUST_STORE_XIP_ADDR;
+    uint32_t end = sizeof(HT_TrustStoreHeader_t);
+    uint8_t data_hash[32];
+    uint8_t digest[32];
+
+    if (hdr->magic != HT_TRUST_STORE_MAGIC || hdr->version != HT_TRUST_STORE_VERSION ||
+        hdr->count == 0 || hdr->count > HT_TRUST_STORE_MAX_ITEMS)
+        return NULL;
+
+    // Os itens sao contiguos e dentro da area
+    for (uint16_t i = 0; i < hdr->count; i++) {
+        if (hdr->entry[i].offset != end || hdr->entry[i].len > FLASH_TRUST_STORE_LEN - end)
+            return NULL;
+        end += hdr->entry[i].len;
+    }
+
+    mbedtls_sha256_ret((const uint8_t *)hdr + sizeof(HT_TrustStoreHeader_t), end - sizeof(HT_TrustStoreHeader_t), data_hash, 0);
+    HT_TrustStore_Digest(hdr, data_hash, digest);
+
+    return memcmp(digest, hdr->sha256, sizeof(digest)) == 0 ? hdr : NULL;
+}
+
+static bool HT_TrustStore_Write(HT_TrustWriter_t *w, const uint8_t *data, size_t len) {
+    if (len > FLASH_TRUST_STORE_LEN - w->offset)
+        return false;
+
+    if (w->write && BSP_QSPI_Write_Safe((uint8_t *)data, FLASH_TRUST_STORE_START + w->offset, len) != QSPI_OK)
+        return false;
+
+    mbedtls_sha256_update_ret(&w->sha, data, len);
+    w->offset += len;
+
+    return true;
+}
+
+static bool HT_TrustStore_WritePem(HT_TrustWriter_t *w, const uint8_t *pem, size_t len) {
+    const uint8_t *p = pem;
+    const uint8_t *end = pem + len;
+    bool in_block = false;
+    bool found = false;
+
+    while (p < end && *p != '\0') {
+        const uint8_t *eol = memchr(p, '\n', end - p);
+        size_t line_len;
+        size_t olen;
+
+        if (eol == NULL)
+            eol = end;
+        line_len = eol - p;
+        if (line_len > 0 && p[line_len - 1] == '\r')
+            line_len--;
+
+        if (line_len >= 10 && memcmp(p, "-----BEGIN", 10) == 0) {
+            in_block = true;
+        } else if (line_len >= 8 && memcmp(p, "-----END", 8) == 0) {
+            found = found || in_block;
+            in_block = false;
+        } else if (in_block && line_len > 0) {
+            // Cabecalhos como Proc-Type (chave cifrada) falham aqui e abortam o provisionamento
+            if (line_len > HT_TRUST_PEM_LINE_MAX ||
+                mbedtls_base64_decode(trustLine, sizeof(trustLine), &olen, p, line_len) != 0 ||
+                !HT_TrustStore_Write(w, trustLine, olen))
+                return false;
+        }
+
+        p = eol + 1;
+    }
+
+    return found && !in_block;
+}
+
+static bool HT_TrustStore_Build(const HT_TrustItem_t *items, uint8_t count, bool write, HT_TrustStoreHeader_t *hdr) {
+    HT_TrustWriter_t w;
+    uint8_t data_hash[32];
+    bool ok = true;
+
+    memset(hdr, 0, sizeof(HT_TrustStoreHeader_t));
+    hdr->magic = HT_TRUST_STORE_MAGIC;
+    hdr->version = HT_TRUST_STORE_VERSION;
+    hdr->count = count;
+
+    w.offset = sizeof(HT_TrustStoreHeader_t);
+    w.write = write;
+    mbedtls_sha256_init(&w.sha);
+    mbedtls_sha256_starts_ret(&w.sha, 0);
+
+    for (uint8_t i = 0; i < count && ok; i++) {
+        const HT_TrustItem_t *item = &items[i];
+
+        hdr->entry[i].type = item->type;
+        hdr->entry[i].offset = w.offset;
+
+        if (item->len > 0 && item->data[0] == '-')
+            ok = HT_TrustStore_WritePem(&w, item->data, item->len);
+        else
+            ok = item->len > 0 && HT_TrustStore_Write(&w, item->data, item->len);
+
+        hdr->entry[i].len = w.offset - hdr->entry[i].offset;
+    }
+
+    mbedtls_sha256_finish_ret(&w.sha, data_hash);
+    mbedtls_sha256_free(&w.sha);
+
+    if (ok)
+        HT_TrustStore_Digest(hdr, data_hash, hdr->sha256);
+
+    return ok;
+}
+
+bool HT_TrustStore_Get(HT_TrustType type, const uint8_t **data, size_t *len) {
+    if (!trustChecked) {
+        trustStore = HT_TrustStore_Check();
+        trustChecked = true;
+    }
+
+    if (trustStore == NULL)
+        return false;
+
+    for (uint16_t i = 0; i < trustStore->count; i++) {
+        if (trustStore->entry[i].type == (uint32_t)type) {
+            *data = (const uint8_t *)HT_TRUST_STORE_XIP_ADDR + trustStore->entry[i].offset;
+            *len = trustStore->entry[i].len;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool HT_TrustStore_Provision(const HT_TrustItem_t *items, uint8_t count) {
+    const HT_TrustStoreHeader_t *current;
+    uint32_t used;
+
+    if (count == 0 || count > HT_TRUST_STORE_MAX_ITEMS)
+        return false;
+
+    for (uint8_t i = 0; i < count; i++)
+        for (uint8_t j = i + 1; j < count; j++)
+            if (items[i].type == items[j].type)
+                return false;
+
+    // Passada sem escrita: valida os itens e permite comparar com o que ja esta gravado
+    if (!HT_TrustStore_Build(items, count, false, &trustHdr)) {
+        printf("Trust store: item invalido\n");
+        return false;
+    }
+
+    current = HT_TrustStore_Check();
+    if (current != NULL && memcmp(current, &trustHdr, sizeof(trustHdr)) == 0)
+        return true;
+
+    used = trustHdr.entry[count - 1].offset + trustHdr.entry[count - 1].len;
+    trustChecked = false;
+
+    // O setor do cabecalho e apagado primeiro: uma falha no meio deixa a area invalida
+    for (uint32_t addr = 0; addr < used; addr += HT_TRUST_STORE_SECTOR_SIZE) {
+        if (BSP_QSPI_Erase_Safe(FLASH_TRUST_STORE_START + addr, HT_TRUST_STORE_SECTOR_SIZE) != QSPI_OK) {
+            printf("Trust store: falha ao apagar a flash\n");
+            return false;
+        }
+    }
+
+    if (!HT_TrustStore_Build(items, count, true, &trustHdr) ||
+        BSP_QSPI_Write_Safe((uint8_t *)&trustHdr, FLASH_TRUST_STORE_START, sizeof(trustHdr)) != QSPI_OK) {
+        printf("Trust store: falha ao gravar a flash\n");
+        return false;
+    }
+
+    printf("Trust store gravado: %lu bytes\n", used);
+    return true;
+}
+
+void HT_TrustStore_Erase(void) {
+    BSP_QSPI_Erase_Safe(FLASH_TRUST_STORE_START, HT_TRUST_STORE_SECTOR_SIZE);
+    trustStore = NULL;
+    trustChecked = true;
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
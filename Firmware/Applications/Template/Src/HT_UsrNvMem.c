@@ -0,0 +1,58 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+#include "HT_UsrNvMem.h"
+#include "slpman_qcx212.h"
+#include <string.h>
+
+static HT_UsrNvMem_t *usrNvMem = NULL;
+
+HT_UsrNvMem_t *HT_UsrNvMem_Get(void) {
+    HT_UsrNvMem_t *mem;
+
+    if (usrNvMem != NULL)
+        return usrNvMem;
+
+    mem = (HT_UsrNvMem_t *)slpManGetUsrNVMem();
+    if (mem == NULL)
+        return NULL;
+
+    if (mem->magic != HT_USRNVMEM_MAGIC || mem->version != HT_USRNVMEM_VERSION || mem->size > sizeof(HT_UsrNvMem_t)) {
+        // Conteudo de outra aplicacao ou de um layout incompativel: comeca do zero
+        memset(mem, 0, sizeof(HT_UsrNvMem_t));
+        mem->magic = HT_USRNVMEM_MAGIC;
+        mem->version = HT_USRNVMEM_VERSION;
+        mem->size = sizeof(HT_UsrNvMem_t);
+        slpManUpdateUserNVMem();
+    } else if (mem->size < sizeof(HT_UsrNvMem_t)) {
+        // Imagem anterior com menos secoes: preserva o que existe e zera o restante
+        memset((uint8_t *)mem + mem->size, 0, sizeof(HT_UsrNvMem_t) - mem->size);
+        mem->size = sizeof(HT_UsrNvMem_t);
+        slpManUpdateUserNVMem();
+    }
+
+    usrNvMem = mem;
+    return usrNvMem;
+}
+
+void HT_UsrNvMem_Update(void) {
+    slpManUpdateUserNVMem();
+}
+
+void HT_UsrNvMem_Flush(void) {
+    slpManFlushUsrNVMem();
+}
+
+/************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -17,12 +17,25 @@
 #include "ps_lib_api.h"
 #include "flash_qcx212.h"
 #include "time.h"
+#include "HT_UsrNvMem.h"
+#include "memory_arena_qcx212.h"
+#include "HT_Sleep.h"
+#include "senseclima.h"
+#include "HT_CIoT.h"
+#include "HT_NetProvision.h"
+#include "HT_Energy.h"
+#include "HT_Policy.h"
+#include "HT_Samples.h"
+#include "HT_Fota.h"
+#include "HT_Schedule.h"
 
 
 static StaticTask_t initTask;
 static uint8_t appTaskStack[INIT_TASK_STACK_SIZE];
 static volatile uint32_t Event;
 static QueueHandle_t psEventQueueHandle;
+static StaticQueue_t psEventQueueCb;
+static uint8_t psEventQueueStorage[APP_EVENT_QUEUE_SIZE * sizeof(eventCallbackMessage_t)];
 static uint8_t gImsi[16] = {0};
 static uint32_t gCellID = 0;
 static NmAtiSyncRet gNetworkInfo;
@@ -30,10 +43,6 @@ static uint8_t mqttEpSlpHandler = 0xff;
 
 static volatile uint8_t simReady = 0;
 
-typedef struct {
-    time_t sleep_start_time;
-} DebugTimestamp_t;
-
 static uint32_t uart_cntrl = (ARM_USART_MODE_ASYNCHRONOUS | ARM_USART_DATA_BITS_8 | ARM_USART_PARITY_NONE | 
                                 ARM_USART_STOP_BITS_1 | ARM_USART_FLOW_CONTROL_NONE);
 
@@ -43,31 +52,11 @@ extern void mqtt_demo_onenet(void);
 
 extern USART_HandleTypeDef huart1;
 
-static void HT_SetConnectioParameters(void) {
-    uint8_t cid = 0;
-    PsAPNSetting apnSetting;
-    int32_t ret;
-    uint8_t networkMode = 0; //nb-iot network mode
-    uint8_t bandNum = 1;
-    uint8_t band = 28;
-
-    ret = appSetBandModeSync(networkMode, bandNum, &band);
-    if(ret == CMS_RET_SUCC) {
-        printf("SetBand Result: %d\n", ret);
-    
-    }
-
-    apnSetting.cid = 0;
-    apnSetting.apnLength = strlen("iot.datatem.com.br");
-    strcpy((char *)apnSetting.apnStr, "iot.datatem.com.br");
-    apnSetting.pdnType = CMI_PS_PDN_TYPE_IP_V4V6;
-    ret = appSetAPNSettingSync(&apnSetting, &cid);
-}
-
 static void sendQueueMsg(uint32_t msgId, uint32_t xTickstoWait) {
-    eventCallbackMessage_t *queueMsg = NULL;
-    queueMsg = malloc(sizeof(eventCallbackMessage_t));
-    queueMsg->messageId = msgId;
+    eventCallbackMessage_t queueMsg = {0};
+
+    // A mensagem e copiada para o armazenamento estatico da fila
+    queueMsg.messageId = msgId;
     if (psEventQueueHandle)
     {
         if (pdTRUE != xQueueSend(psEventQueueHandle, &queueMsg, xTickstoWait))
@@ -82,6 +71,9 @@ static INT32 registerPSUrcCallback(urcID_t eventID, void *param, uint32_t paramL
     CmiPsCeregInd *cereg = NULL;
     UINT8 rssi = 0;
     NmAtiNetifInfo *netif = NULL;
+    CmiPsRecvDlNonIpDataInd *nonIp = NULL;
+
+    HT_Sleep_StackEvent((uint16_t)eventID);
 
     switch(eventID)
     {
@@ -101,6 +93,10 @@ static INT32 registerPSUrcCallback(urcID_t eventID, void *param, uint32_t paramL
         case NB_URC_ID_PS_BEARER_ACTED:
         {
             HT_TRACE(UNILOG_MQTT, mqttAppTask82, P_INFO, 0, "Default bearer activated");
+#if HT_CIOT_ENABLE == 1
+            // PDN Non-IP: nao ha interface de rede, o bearer ativo basta
+            sendQueueMsg(QMSG_ID_NW_NONIP_READY, 0);
+#endif
             break;
         }
         case NB_URC_ID_PS_BEARER_DEACTED:
@@ -108,6 +104,12 @@ static INT32 registerPSUrcCallback(urcID_t eventID, void *param, uint32_t paramL
             HT_TRACE(UNILOG_MQTT, mqttAppTask83, P_INFO, 0, "Default bearer Deactivated");
             break;
         }
+        case NB_URC_ID_PS_NON_IP_DATA_IND:
+        {
+            nonIp = (CmiPsRecvDlNonIpDataInd *)param;
+            HT_CIoT_Downlink(nonIp->pData, nonIp->length);
+            break;
+        }
         case NB_URC_ID_PS_CEREG_CHANGED:
         {
             cereg = (CmiPsCeregInd *)param;
@@ -131,20 +133,22 @@ static INT32 registerPSUrcCallback(urcID_t eventID, void *param, uint32_t paramL
 
 static void HT_MQTTExampleTask(void *arg){
     int32_t ret;
-    uint8_t psmMode = 0, actType = 0;
+    uint8_t actType = 0;
     uint16_t tac = 0;
-    uint32_t tauTime = 0, activeTime = 0, cellID = 0, nwEdrxValueMs = 0, nwPtwMs = 0;
+    uint32_t cellID = 0, nwEdrxValueMs = 0, nwPtwMs = 0;
+
+    HT_Energy_Begin();
 
     // --- Timestamping after wakeup ---
     // Esta seção é executada logo após o dispositivo acordar do sono profundo (que causa um reset).
-    DebugTimestamp_t *nv_timestamp = (DebugTimestamp_t *)slpManGetUsrNVMem();
+    HT_UsrNvMem_t *nv_timestamp = HT_UsrNvMem_Get();
     if (nv_timestamp != NULL && nv_timestamp->sleep_start_time != 0) {
         time_t wakeup_time = OsaSystemTimeReadSecs();
         time_t sleep_start = nv_timestamp->sleep_start_time;
         
         // Limpa o timestamp na memória não volátil para evitar reimpressão em caso de reset acidental.
         nv_timestamp->sleep_start_time = 0;
-        slpManUpdateUserNVMem();
+        HT_UsrNvMem_Update();
 
         // Apenas imprime se o tempo de despertar for maior, para evitar logs com valores inválidos.
         if (wakeup_time > sleep_start) {
@@ -154,18 +158,18 @@ static void HT_MQTTExampleTask(void *arg){
     }
     // --- Fim do timestamping ---
 
-    eventCallbackMessage_t *queueItem = NULL;
+    eventCallbackMessage_t queueItem;
 
     registerPSEventCallback(NB_GROUP_ALL_MASK, registerPSUrcCallback);
-    psEventQueueHandle = xQueueCreate(APP_EVENT_QUEUE_SIZE, sizeof(eventCallbackMessage_t*));
+    psEventQueueHandle = xQueueCreateStatic(APP_EVENT_QUEUE_SIZE, sizeof(eventCallbackMessage_t), psEventQueueStorage, &psEventQueueCb);
     if (psEventQueueHandle == NULL)
     {
         HT_TRACE(UNILOG_MQTT, mqttAppTask0, P_INFO, 0, "psEventQueue create error!");
         return;
     }
 
-    slpManApplyPlatVoteHandle("EP_MQTT",&mqttEpSlpHandler);
-    slpManPlatVoteDisableSleep(mqttEpSlpHandler, SLP_ACTIVE_STATE); //SLP_SLP2_STATE 
+    // Voto liberado por HT_Sleep_EnterSleep() antes da hibernacao
+    mqttEpSlpHandler = HT_Sleep_Hold("EP_MQTT", SLP_ACTIVE_STATE); //SLP_SLP2_STATE 
     HT_TRACE(UNILOG_MQTT, mqttAppTask1, P_INFO, 0, "first time run mqtt example");
 
     HAL_USART_InitPrint(&huart1, GPR_UART1ClkSel_26M, uart_cntrl, 115200);
@@ -174,14 +178,35 @@ static void HT_MQTTExampleTask(void *arg){
     printf("DANILO CUNHA - SENSE CLIMA\n");
     printf("========================================\n\n");
     printf("Iniciando conexao...\n");
+    HT_Sleep_ReportLastEntry();
+    HT_Schedule_Begin();
+
+    // Despertar pelo temporizador sem envio nem resumo vencidos: so a leitura, sem attach nem conexao
+    if (slpManGetWakeupSrc() == WAKEUP_FROM_RTC && !HT_Schedule_NeedsNetwork() && !HT_FOTA_IsBusy())
+        HT_FSM_SampleOnlyWake();
+
     // while (1) {
     //     DHT22_Init();
     //     HT_FSM_MQTTPublishDHT22State();
     //     osDelay(1000);
     // }
 
-    while(!simReady);
-    HT_SetConnectioParameters();
+    if (HT_Sleep_PsmResumed()) {
+        // Registro mantido durante a hibernacao: a interface pode ja estar ativa antes do callback
+        printf("Despertar de PSM: sem novo attach\n");
+        HT_Energy_Start(HT_ENERGY_PHASE_ATTACH);
+#if HT_CIOT_ENABLE == 1
+        sendQueueMsg(QMSG_ID_NW_NONIP_READY, 0);
+#else
+        if (appGetNetInfoSync(0, &gNetworkInfo) == CMS_RET_SUCC &&
+            gNetworkInfo.body.netInfoRet.netifInfo.netStatus == NM_NETIF_ACTIVATED)
+            sendQueueMsg(QMSG_ID_NW_IPV4_READY, 0);
+#endif
+    } else {
+        while(!simReady);
+        HT_Energy_Start(HT_ENERGY_PHASE_ATTACH);
+        HT_NetProvision_Apply();
+    }
 
     // Get led status from the Python software
     //HT_FSM_UpdateUserLedState();
@@ -190,11 +215,12 @@ static void HT_MQTTExampleTask(void *arg){
     {
         if (xQueueReceive(psEventQueueHandle, &queueItem, portMAX_DELAY))
         {
-            switch(queueItem->messageId)
+            switch(queueItem.messageId)
             {
                 case QMSG_ID_NW_IPV4_READY:
                 case QMSG_ID_NW_IPV6_READY:
                 case QMSG_ID_NW_IPV4_6_READY:
+                    HT_Energy_Start(HT_ENERGY_PHASE_IDLE);
                     appGetImsiNumSync((CHAR *)gImsi);
                     HT_STRING(UNILOG_MQTT, mqttAppTask2, P_SIG, "IMSI = %s", gImsi);
                 
@@ -217,23 +243,25 @@ static void HT_MQTTExampleTask(void *arg){
                     ret = appGetEDRXSettingSync(&actType, &nwEdrxValueMs, &nwPtwMs);
                     HT_TRACE(UNILOG_MQTT, mqttAppTask5, P_INFO, 4, "actType=%d, nwEdrxValueMs=%d nwPtwMs=%d ret=%d", actType, nwEdrxValueMs, nwPtwMs, ret);
                     printf("actType=%d, nwEdrxValueMs=%d nwPtwMs=%d ret=%d\n", actType, nwEdrxValueMs, nwPtwMs, ret);
-                    //psmMode = 1;
-                    psmMode = 0;
-                    tauTime = 4000;
-                    activeTime = 30;
-
-                    {
-                        appSetPSMSettingSync(0,0,0);
-                        appGetPSMSettingSync(&psmMode, &tauTime, &activeTime);
-                        HT_TRACE(UNILOG_MQTT, mqttAppTask6, P_INFO, 3, "Get PSM info mode=%d, TAU=%d, ActiveTime=%d", psmMode, tauTime, activeTime);
-                        printf("Get PSM info mode=%d, TAU=%d, ActiveTime=%d\n", psmMode, tauTime, activeTime);
-                        }
+
+                    // Bateria e cobertura decidem o intervalo deste ciclo
+                    HT_Policy_Update();
+
+                    // PSM com T3412 acima do periodo de envio, ou desativado conforme HT_SLEEP_USE_PSM
+                    HT_Sleep_ConfigurePsm(HT_Schedule_Period(HT_SCHEDULE_UPLOAD));
 
                     //HT_FSM_UpdateUserLedState();
                      // A rede está pronta, agora podemos iniciar a máquina de estados da aplicação.
                     
                     HT_Fsm();
 
+                    break;
+                case QMSG_ID_NW_NONIP_READY:
+                    // Telemetria pelo plano de controle, sem IP
+                    HT_Energy_Start(HT_ENERGY_PHASE_IDLE);
+                    HT_Policy_Update();
+                    HT_Sleep_ConfigurePsm(HT_Schedule_Period(HT_SCHEDULE_UPLOAD));
+                    HT_Fsm();
                     break;
                 case QMSG_ID_NW_DISCONNECT:
                     break;
@@ -241,7 +269,6 @@ static void HT_MQTTExampleTask(void *arg){
                 default:
                     break;
             }
-            free(queueItem);
         }
     }
 
@@ -278,6 +305,9 @@ void main_entry(void) {
 
     osKernelInitialize();
 
+    // Arena do mbedTLS: os handshakes ficam fora do heap do sistema
+    qcx212_arena_init();
+
     setvbuf(stdout, NULL, _IONBF, 0);
     
     registerAppEntry(appInit, NULL);
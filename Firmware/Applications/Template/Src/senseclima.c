@@ -2,7 +2,9 @@
 #include "HT_DHT22.h"
 #include "HT_MQTT_Api.h"
 #include "HT_Sleep.h"
+#include "HT_Energy.h"
 #include <stdio.h>
+#include <inttypes.h>
 #include <string.h>
 #include <stdlib.h>
 
@@ -26,14 +28,14 @@ static bool interval_configured_via_mqtt = false;
 static void LoadSleepIntervalFromNVRAM(void) {
     // Nesta versao simplificada, usamos apenas a variavel global
     // A persistencia real na NVRAM seria implementada com a API especifica do hardware
-    printf("Carregando intervalo de sono: %lu ms (valor padrao)\n", current_sleep_interval_ms);
+    printf("Carregando intervalo de sono: %" PRIu32 " ms (valor padrao)\n", current_sleep_interval_ms);
 }
 
 // Funcao para salvar o intervalo de sono na NVRAM
 static void SaveSleepIntervalToNVRAM(void) {
     // Nesta versao simplificada, apenas logamos o valor
     // A persistencia real na NVRAM seria implementada com a API especifica do hardware
-    printf("Salvando intervalo de sono: %lu ms\n", current_sleep_interval_ms);
+    printf("Salvando intervalo de sono: %" PRIu32 " ms\n", current_sleep_interval_ms);
 }
 
 // Inicializa o módulo SenseClima
@@ -65,9 +67,9 @@ bool SenseClima_SetSleepIntervalValue(uint32_t interval_ms) {
     current_sleep_interval_ms = interval_ms;
     interval_configured_via_mqtt = true;
     
-    printf("Intervalo ATUALIZADO: %lu ms (%lu segundos)\n", 
+    printf("Intervalo ATUALIZADO: %" PRIu32 " ms (%" PRIu32 " segundos)\n", 
            current_sleep_interval_ms, current_sleep_interval_ms / 1000);
-    printf("Valor anterior: %lu ms (%lu segundos)\n", previous_interval, previous_interval / 1000);
+    printf("Valor anterior: %" PRIu32 " ms (%" PRIu32 " segundos)\n", previous_interval, previous_interval / 1000);
     
     // Salva o novo intervalo na NVRAM
     SaveSleepIntervalToNVRAM();
@@ -204,52 +206,58 @@ void SenseClima_MessageHandler(uint8_t *payload, uint8_t payload_len,
     }
 }
 
+bool SenseClima_ReadDHT22(float *temperature, float *humidity) {
+    int attempt;
+
+    // Tenta ler o sensor várias vezes
+    for (attempt = 0; attempt < MAX_DHT_READ_ATTEMPTS; attempt++) {
+        int dht_status = DHT22_Read(temperature, humidity);
+        
+        if (dht_status == 0)
+            return true;
+
+        printf("Tentativa %d: Erro na leitura (codigo: %d)\n", attempt + 1, dht_status);
+        
+        if (attempt < MAX_DHT_READ_ATTEMPTS - 1) {
+            // Aguarda antes da próxima tentativa
+            osDelay(DHT_READ_RETRY_INTERVAL);
+        }
+    }
+
+    printf("Falha na leitura apos %d tentativas\n", MAX_DHT_READ_ATTEMPTS);
+    return false;
+}
+
 void SenseClima_PublishDHT22State(void) {
     float temperature;
     float humidity;
     char temp_payload[16];
     char hum_payload[16];
     char error_payload[] = "error";
-    int attempt = 0;
     bool publish_success = false;
     int mqtt_reconnect_attempts = 0;
     const int MAX_MQTT_RECONNECT_ATTEMPTS = 3;
     
     printf("\n=== LEITURA SENSOR DHT22 ===\n");
+    HT_Energy_Start(HT_ENERGY_PHASE_SENSE);
     
-    // Tenta ler o sensor várias vezes
-    for (attempt = 0; attempt < MAX_DHT_READ_ATTEMPTS; attempt++) {
-        int dht_status = DHT22_Read(&temperature, &humidity);
-        
-        if (dht_status == 0) {
-            // Leitura bem-sucedida, formata os valores
-            int temp_int_x10 = (int)(temperature * 10);
-            int hum_int_x10 = (int)(humidity * 10);
+    if (SenseClima_ReadDHT22(&temperature, &humidity)) {
+        // Leitura bem-sucedida, formata os valores
+        int temp_int_x10 = (int)(temperature * 10);
+        int hum_int_x10 = (int)(humidity * 10);
 
-            snprintf(temp_payload, sizeof(temp_payload), "%d.%d", temp_int_x10 / 10, temp_int_x10 % 10);
-            snprintf(hum_payload, sizeof(hum_payload), "%d.%d", hum_int_x10 / 10, hum_int_x10 % 10);
+        snprintf(temp_payload, sizeof(temp_payload), "%d.%d", temp_int_x10 / 10, temp_int_x10 % 10);
+        snprintf(hum_payload, sizeof(hum_payload), "%d.%d", hum_int_x10 / 10, hum_int_x10 % 10);
 
-            printf("Leitura OK: Temp=%sC, Umid=%s%%\n", temp_payload, hum_payload);
-            break;
-        } else {
-            printf("Tentativa %d: Erro na leitura (codigo: %d)\n", attempt + 1, dht_status);
-            
-            if (attempt < MAX_DHT_READ_ATTEMPTS - 1) {
-                // Aguarda antes da próxima tentativa
-                osDelay(DHT_READ_RETRY_INTERVAL);
-            }
-        }
-    }
-    
-    // Verifica se conseguiu ler o sensor
-    if (attempt >= MAX_DHT_READ_ATTEMPTS) {
-        printf("Falha na leitura apos %d tentativas\n", MAX_DHT_READ_ATTEMPTS);
+        printf("Leitura OK: Temp=%sC, Umid=%s%%\n", temp_payload, hum_payload);
+    } else {
         // Usa a mensagem de erro para ambas as publicações
         strcpy(temp_payload, error_payload);
         strcpy(hum_payload, error_payload);
     }
     
     // Tenta publicar os dados (com retry se necessário)
+    HT_Energy_Start(HT_ENERGY_PHASE_PUBLISH);
     for (int retry = 0; retry < 3; retry++) {
         // Verifica se o cliente MQTT está conectado
         if (!mqttClient.isconnected) {
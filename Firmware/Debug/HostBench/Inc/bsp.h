@@ -0,0 +1,9 @@
+/*!
+ * \file bsp.h
+ * \brief Empty placeholder: nothing from this SDK header is used by the host build.
+ */
+
+#ifndef HOST_BSP_H
+#define HOST_BSP_H
+
+#endif /* HOST_BSP_H */
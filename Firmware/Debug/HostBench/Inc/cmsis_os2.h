@@ -0,0 +1,45 @@
+/*!
+ * \file cmsis_os2.h
+ * \brief CMSIS-RTOS2 subset for the host build (see host_os.c).
+ */
+
+#ifndef HOST_CMSIS_OS2_H
+#define HOST_CMSIS_OS2_H
+
+#include <stdint.h>
+#include <stddef.h>
+
+typedef void *osThreadId_t;
+typedef void (*osThreadFunc_t)(void *argument);
+
+typedef enum {
+    osPriorityNone          =  0,
+    osPriorityIdle          =  1,
+    osPriorityLow           =  8,
+    osPriorityBelowNormal   = 16,
+    osPriorityBelowNormal7  = 16+7,
+    osPriorityNormal        = 24,
+    osPriorityAboveNormal   = 32,
+    osPriorityHigh          = 40,
+    osPriorityRealtime      = 48,
+} osPriority_t;
+
+typedef struct {
+    const char *name;
+    uint32_t attr_bits;
+    void *cb_mem;
+    uint32_t cb_size;
+    void *stack_mem;
+    uint32_t stack_size;
+    osPriority_t priority;
+    uint32_t tz_module;
+    uint32_t reserved;
+} osThreadAttr_t;
+
+typedef uint8_t StaticTask_t;
+
+osThreadId_t osThreadNew(osThreadFunc_t func, void *argument, const osThreadAttr_t *attr);
+int32_t osDelay(uint32_t ticks);
+uint32_t osKernelGetTickCount(void);
+
+#endif /* HOST_CMSIS_OS2_H */
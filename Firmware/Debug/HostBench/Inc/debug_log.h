@@ -0,0 +1,12 @@
+/*!
+ * \file debug_log.h
+ * \brief Unilog trace macros compiled out on the host.
+ */
+
+#ifndef HOST_DEBUG_LOG_H
+#define HOST_DEBUG_LOG_H
+
+#define HT_TRACE(moduleId, subId, debugLevel, argLen, format, ...)  ((void)0)
+#define HT_STRING(moduleId, subId, debugLevel, format, ...)          ((void)0)
+
+#endif /* HOST_DEBUG_LOG_H */
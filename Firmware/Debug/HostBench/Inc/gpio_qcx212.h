@@ -0,0 +1,9 @@
+/*!
+ * \file gpio_qcx212.h
+ * \brief Empty placeholder: nothing from this SDK header is used by the host build.
+ */
+
+#ifndef HOST_GPIO_QCX212_H
+#define HOST_GPIO_QCX212_H
+
+#endif /* HOST_GPIO_QCX212_H */
@@ -0,0 +1,28 @@
+/*!
+ * \file main.h
+ * \brief Host replacement for Applications/Template/Inc/main.h.
+ *
+ * The target main.h pulls in the whole HTNB32L SDK (lwIP, PS, unilog). The
+ * host build only needs the handful of OS and logging symbols used by
+ * MQTTClient.c, HT_MQTT_Api.c and senseclima.c, which are provided by the
+ * shim headers in this directory.
+ */
+
+#ifndef __MAIN_H__
+#define __MAIN_H__
+
+#include <stdint.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "cmsis_os2.h"
+#include "debug_log.h"
+#include "HT_Fsm.h"
+#include "MQTTClient.h"
+#include "HT_MQTT_Api.h"
+
+#endif /* __MAIN_H__ */
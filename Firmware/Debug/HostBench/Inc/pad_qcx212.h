@@ -0,0 +1,9 @@
+/*!
+ * \file pad_qcx212.h
+ * \brief Empty placeholder: nothing from this SDK header is used by the host build.
+ */
+
+#ifndef HOST_PAD_QCX212_H
+#define HOST_PAD_QCX212_H
+
+#endif /* HOST_PAD_QCX212_H */
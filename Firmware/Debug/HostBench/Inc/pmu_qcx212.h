@@ -0,0 +1,9 @@
+/*!
+ * \file pmu_qcx212.h
+ * \brief Empty placeholder: nothing from this SDK header is used by the host build.
+ */
+
+#ifndef HOST_PMU_QCX212_H
+#define HOST_PMU_QCX212_H
+
+#endif /* HOST_PMU_QCX212_H */
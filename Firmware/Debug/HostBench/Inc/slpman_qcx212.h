@@ -0,0 +1,18 @@
+/*!
+ * \file slpman_qcx212.h
+ * \brief Sleep manager types referenced by application headers on the host.
+ */
+
+#ifndef HOST_SLPMAN_QCX212_H
+#define HOST_SLPMAN_QCX212_H
+
+typedef enum
+{
+    SLP_ACTIVE_STATE = 0,
+    SLP_IDLE_STATE,
+    SLP_SLP1_STATE,
+    SLP_SLP2_STATE,
+    SLP_HIB_STATE,
+} slpManSlpState_t;
+
+#endif /* HOST_SLPMAN_QCX212_H */
@@ -0,0 +1,9 @@
+/*!
+ * \file uart_qcx212.h
+ * \brief Empty placeholder: nothing from this SDK header is used by the host build.
+ */
+
+#ifndef HOST_UART_QCX212_H
+#define HOST_UART_QCX212_H
+
+#endif /* HOST_UART_QCX212_H */
@@ -0,0 +1,176 @@
+/*!
+ * \file host_bench.c
+ * \brief Runs the SenseClima wake cycle (connect -> subscribe -> publish ->
+ *        disconnect) on Linux against a real broker and reports one
+ *        "BENCH {json}" line per cycle on stdout.
+ *
+ * The MQTT client, HT_MQTT_Api.c and senseclima.c are the target sources;
+ * this file only supplies what HT_Fsm.c and HT_DHT22.c provide on the board.
+ *
+ * Usage: mqtt_host_bench [-h host] [-p port] [-n cycles] [-i client_id] [-y yield_ms]
+ */
+
+#include <getopt.h>
+#include <time.h>
+#include <unistd.h>
+
+#include "main.h"
+#include "HT_DHT22.h"
+#include "senseclima.h"
+#include "HT_Energy.h"
+
+MQTTClient mqttClient;
+Network mqttNetwork;
+volatile uint8_t subscribe_callback = 0;
+
+static uint8_t mqttSendbuf[HT_MQTT_BUFFER_SIZE] = {0};
+static uint8_t mqttReadbuf[HT_MQTT_BUFFER_SIZE] = {0};
+
+static char brokerAddr[64] = {"127.0.0.1"};
+static int32_t brokerPort = 1883;
+static char clientID[32] = {"SIP_HTNB32L"};
+static const char username[] = {""};
+static const char password[] = {""};
+
+static uint32_t dhtReadCount = 0;
+static int yieldMs = 0;
+static unsigned long streamedBytes = 0;
+
+/* --- Board replacements -------------------------------------------------- */
+
+HT_ConnectionStatus HT_FSM_MQTTConnect(void) {
+    if(HT_MQTT_Connect(&mqttClient, &mqttNetwork, brokerAddr, brokerPort, HT_MQTT_SEND_TIMEOUT, HT_MQTT_RECEIVE_TIMEOUT,
+                clientID, (char *)username, (char *)password, HT_MQTT_VERSION, HT_MQTT_KEEP_ALIVE_INTERVAL,
+                mqttSendbuf, HT_MQTT_BUFFER_SIZE, mqttReadbuf, HT_MQTT_BUFFER_SIZE)) {
+        return HT_NOT_CONNECTED;
+    }
+
+    return HT_CONNECTED;
+}
+
+void HT_FSM_SetSubscribeBuff(uint8_t *buff, uint8_t payload_len) {
+    (void)buff;
+    (void)payload_len;
+}
+
+HT_EnergyPhase HT_Energy_Start(HT_EnergyPhase phase) {
+    return phase;
+}
+
+void DHT22_Init(void) {
+}
+
+int DHT22_Read(float *temperature, float *humidity) {
+    /* Deterministic but varying values so consecutive payloads differ in size. */
+    dhtReadCount++;
+    *temperature = 20.0f + (float)(dhtReadCount % 100) / 10.0f;
+    *humidity = 55.0f + (float)(dhtReadCount % 37) / 10.0f;
+
+    return DHT22_OK;
+}
+
+/* --- Benchmark ------------------------------------------------------------ */
+
+static int HostBench_StreamHandler(MQTTStreamData *sd) {
+    /* Large messages are only counted; a real consumer writes them to flash. */
+    if (sd->event == MQTT_STREAM_CHUNK)
+        streamedBytes += sd->chunk_len;
+
+    return SUCCESS;
+}
+
+static uint64_t HostBench_NowUs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000u + (uint64_t)ts.tv_nsec / 1000u;
+}
+
+static void HostBench_RunCycle(uint32_t cycle) {
+    uint64_t t0, t_conn, t_sub, t_pub, t_disc;
+    MQTTInboundStats inbound;
+    int connected;
+    int sub_rc = FAILURE;
+
+    streamedBytes = 0;
+    t0 = HostBench_NowUs();
+    connected = (HT_FSM_MQTTConnect() == HT_CONNECTED);
+    t_conn = HostBench_NowUs();
+
+    if (connected)
+        sub_rc = MQTTSubscribe(&mqttClient, INTERVAL_TOPIC, QOS1, HT_MQTT_SubscribeCallback);
+    if (connected && yieldMs > 0)
+        MQTTYield(&mqttClient, yieldMs);  /* picks up retained messages sent after the SUBACK */
+    t_sub = HostBench_NowUs();
+
+    if (connected)
+        SenseClima_PublishDHT22State();
+    MQTTInboundDispatch(&mqttClient, 0);
+    t_pub = HostBench_NowUs();
+
+    if (mqttClient.isconnected)
+        MQTTDisconnect(&mqttClient);
+    if (mqttNetwork.disconnect != NULL)
+        mqttNetwork.disconnect(&mqttNetwork);
+    t_disc = HostBench_NowUs();
+
+    MQTTInboundGetStats(&mqttClient, &inbound);
+
+    fflush(stdout);
+    printf("BENCH {\"cycle\":%u,\"connected\":%d,\"subscribed\":%d,"
+           "\"connect_us\":%llu,\"subscribe_us\":%llu,\"publish_us\":%llu,\"disconnect_us\":%llu,\"total_us\":%llu,"
+           "\"bytes_sent\":%lu,\"bytes_received\":%lu,\"sleep_interval_ms\":%u,"
+           "\"inbound_delivered\":%u,\"inbound_high_watermark\":%u,\"inbound_dropped\":%u,\"inbound_rejected\":%u,"
+           "\"streamed_bytes\":%lu}\n",
+           cycle, connected, sub_rc == SUCCESS,
+           (unsigned long long)(t_conn - t0), (unsigned long long)(t_sub - t_conn),
+           (unsigned long long)(t_pub - t_sub), (unsigned long long)(t_disc - t_pub),
+           (unsigned long long)(t_disc - t0),
+           mqttNetwork.bytes_sent, mqttNetwork.bytes_received,
+           (unsigned)SenseClima_GetSleepInterval(),
+           inbound.delivered, inbound.high_watermark, inbound.dropped, inbound.rejected,
+           streamedBytes);
+    fflush(stdout);
+}
+
+int main(int argc, char *argv[]) {
+    uint32_t cycles = 1;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "h:p:n:i:y:")) != -1) {
+        switch (opt) {
+        case 'h':
+            snprintf(brokerAddr, sizeof(brokerAddr), "%s", optarg);
+            break;
+        case 'p':
+            brokerPort = atoi(optarg);
+            break;
+        case 'n':
+            cycles = (uint32_t)strtoul(optarg, NULL, 10);
+            break;
+        case 'i':
+            snprintf(clientID, sizeof(clientID), "%s", optarg);
+            break;
+        case 'y':
+            yieldMs = atoi(optarg);
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-h host] [-p port] [-n cycles] [-i client_id] [-y yield_ms]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    setvbuf(stdout, NULL, _IOLBF, 0);
+
+    DHT22_Init();
+    SenseClima_Init();
+    MQTTSetStreamHandler(&mqttClient, HostBench_StreamHandler);
+
+    for (uint32_t i = 0; i < cycles; i++) {
+        /* Every wake starts from a fresh NetworkInit(), as after hibernation. */
+        NetworkInit(&mqttNetwork);
+        HostBench_RunCycle(i);
+    }
+
+    return 0;
+}
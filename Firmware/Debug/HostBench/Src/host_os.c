@@ -0,0 +1,162 @@
+/*!
+ * \file host_os.c
+ * \brief FreeRTOS / CMSIS-RTOS2 subset implemented on pthreads so the
+ *        target MQTT and SenseClima sources run unchanged on Linux.
+ */
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "FreeRTOS.h"
+#include "queue.h"
+#include "cmsis_os2.h"
+
+struct HostQueue {
+    pthread_mutex_t lock;
+    pthread_cond_t  cond;
+    UBaseType_t     length;
+    UBaseType_t     itemSize;
+    UBaseType_t     head;
+    UBaseType_t     count;
+    uint8_t         storage[];
+};
+
+static uint64_t HostMonotonicMs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000u + (uint64_t)ts.tv_nsec / 1000000u;
+}
+
+static void HostDeadline(struct timespec *ts, TickType_t ticks) {
+    clock_gettime(CLOCK_REALTIME, ts);
+    ts->tv_sec  += ticks / 1000u;
+    ts->tv_nsec += (long)(ticks % 1000u) * 1000000L;
+    if (ts->tv_nsec >= 1000000000L) {
+        ts->tv_sec++;
+        ts->tv_nsec -= 1000000000L;
+    }
+}
+
+TickType_t xTaskGetTickCount(void) {
+    return (TickType_t)HostMonotonicMs();
+}
+
+uint32_t osKernelGetTickCount(void) {
+    return (uint32_t)HostMonotonicMs();
+}
+
+int32_t osDelay(uint32_t ticks) {
+    struct timespec ts = { ticks / 1000u, (long)(ticks % 1000u) * 1000000L };
+
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+        ;
+    return 0;
+}
+
+typedef struct {
+    osThreadFunc_t func;
+    void *argument;
+} HostThreadStart;
+
+static void *HostThreadEntry(void *arg) {
+    HostThreadStart start = *(HostThreadStart *)arg;
+
+    free(arg);
+    start.func(start.argument);
+    return NULL;
+}
+
+osThreadId_t osThreadNew(osThreadFunc_t func, void *argument, const osThreadAttr_t *attr) {
+    pthread_t thread;
+    HostThreadStart *start = malloc(sizeof(*start));
+
+    (void)attr;
+    if (start == NULL)
+        return NULL;
+
+    start->func = func;
+    start->argument = argument;
+    if (pthread_create(&thread, NULL, HostThreadEntry, start) != 0) {
+        free(start);
+        return NULL;
+    }
+    pthread_detach(thread);
+
+    return (osThreadId_t)(uintptr_t)thread;
+}
+
+QueueHandle_t xQueueCreate(UBaseType_t uxQueueLength, UBaseType_t uxItemSize) {
+    QueueHandle_t q = calloc(1, sizeof(*q) + uxQueueLength * uxItemSize);
+
+    if (q == NULL)
+        return NULL;
+
+    pthread_mutex_init(&q->lock, NULL);
+    pthread_cond_init(&q->cond, NULL);
+    q->length = uxQueueLength;
+    q->itemSize = uxItemSize;
+
+    return q;
+}
+
+static BaseType_t HostQueueWait(QueueHandle_t q, int wantSpace, TickType_t xTicksToWait) {
+    struct timespec deadline;
+
+    HostDeadline(&deadline, xTicksToWait);
+    while (wantSpace ? (q->count == q->length) : (q->count == 0)) {
+        if (xTicksToWait == 0)
+            return pdFALSE;
+        if (xTicksToWait == portMAX_DELAY)
+            pthread_cond_wait(&q->cond, &q->lock);
+        else if (pthread_cond_timedwait(&q->cond, &q->lock, &deadline) == ETIMEDOUT)
+            return pdFALSE;
+    }
+    return pdTRUE;
+}
+
+BaseType_t xQueueSend(QueueHandle_t q, const void *pvItemToQueue, TickType_t xTicksToWait) {
+    BaseType_t ret;
+
+    pthread_mutex_lock(&q->lock);
+    ret = HostQueueWait(q, 1, xTicksToWait);
+    if (ret == pdTRUE) {
+        UBaseType_t tail = (q->head + q->count) % q->length;
+
+        memcpy(&q->storage[tail * q->itemSize], pvItemToQueue, q->itemSize);
+        q->count++;
+        pthread_cond_broadcast(&q->cond);
+    }
+    pthread_mutex_unlock(&q->lock);
+
+    return ret;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t q, void *pvBuffer, TickType_t xTicksToWait) {
+    BaseType_t ret;
+
+    pthread_mutex_lock(&q->lock);
+    ret = HostQueueWait(q, 0, xTicksToWait);
+    if (ret == pdTRUE) {
+        memcpy(pvBuffer, &q->storage[q->head * q->itemSize], q->itemSize);
+        q->head = (q->head + 1) % q->length;
+        q->count--;
+        pthread_cond_broadcast(&q->cond);
+    }
+    pthread_mutex_unlock(&q->lock);
+
+    return ret;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t q) {
+    UBaseType_t count;
+
+    pthread_mutex_lock(&q->lock);
+    count = q->count;
+    pthread_mutex_unlock(&q->lock);
+
+    return count;
+}
@@ -0,0 +1,356 @@
+#!/usr/bin/env python3
+"""
+Host benchmark runner for the SenseClima MQTT wake cycle.
+
+Starts (optionally) a minimal MQTT 3.1.1 broker, an impairment proxy that adds
+latency / jitter and emulates segment loss as a retransmission stall, runs
+Build/mqtt_host_bench through it and summarises the per-phase timings.
+
+    make && ./mqtt_bench.py -n 50 --delay-ms 300 --jitter-ms 100 --loss 0.02
+    ./mqtt_bench.py --broker test.mosquitto.org:1883 -n 10
+
+Only the Python standard library is used.
+"""
+
+import argparse
+import json
+import os
+import random
+import socket
+import statistics
+import subprocess
+import sys
+import threading
+import time
+
+HERE = os.path.dirname(os.path.abspath(__file__))
+BENCH_BIN = os.path.join(HERE, "Build", "mqtt_host_bench")
+INTERVAL_TOPIC = "hana/externo/senseclima/sensor03/interval"
+
+# --------------------------------------------------------------------------
+# Minimal MQTT 3.1.1 broker (single process, QoS 0/1, retained messages)
+# --------------------------------------------------------------------------
+
+
+def _read_exact(sock, n):
+    data = b""
+    while len(data) < n:
+        chunk = sock.recv(n - len(data))
+        if not chunk:
+            raise ConnectionError
+        data += chunk
+    return data
+
+
+def _read_packet(sock):
+    header = _read_exact(sock, 1)[0]
+    mult, length = 1, 0
+    while True:
+        b = _read_exact(sock, 1)[0]
+        length += (b & 0x7F) * mult
+        if not b & 0x80:
+            break
+        mult *= 128
+    return header, _read_exact(sock, length) if length else b""
+
+
+def _remaining_length(n):
+    out = bytearray()
+    while True:
+        b = n % 128
+        n //= 128
+        out.append(b | 0x80 if n else b)
+        if not n:
+            return bytes(out)
+
+
+def _packet(header, body):
+    return bytes([header]) + _remaining_length(len(body)) + body
+
+
+def _utf8(s):
+    return len(s).to_bytes(2, "big") + s
+
+
+def _topic_matches(filt, topic):
+    f, t = filt.split(b"/"), topic.split(b"/")
+    for i, part in enumerate(f):
+        if part == b"#":
+            return True
+        if i >= len(t) or (part != b"+" and part != t[i]):
+            return False
+    return len(f) == len(t)
+
+
+class MiniBroker:
+    def __init__(self, host="127.0.0.1", port=0):
+        self.srv = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.srv.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.srv.bind((host, port))
+        self.srv.listen(16)
+        self.port = self.srv.getsockname()[1]
+        self.lock = threading.Lock()
+        self.subs = {}          # socket -> list of filters
+        self.retained = {}      # topic -> payload
+        self.publishes = 0
+
+    def retain(self, topic, payload):
+        self.retained[topic] = payload
+
+    def start(self):
+        threading.Thread(target=self._accept, daemon=True).start()
+        return self
+
+    def _accept(self):
+        while True:
+            conn, _ = self.srv.accept()
+            conn.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            threading.Thread(target=self._client, args=(conn,), daemon=True).start()
+
+    def _send(self, conn, data):
+        try:
+            conn.sendall(data)
+        except OSError:
+            pass
+
+    def _deliver(self, conn, topic, payload, retain=False):
+        self._send(conn, _packet(0x30 | (0x01 if retain else 0), _utf8(topic) + payload))
+
+    def _client(self, conn):
+        try:
+            while True:
+                header, body = _read_packet(conn)
+                kind = header >> 4
+                if kind == 1:                               # CONNECT
+                    self._send(conn, _packet(0x20, b"\x00\x00"))
+                elif kind == 3:                             # PUBLISH
+                    qos = (header >> 1) & 3
+                    tlen = int.from_bytes(body[:2], "big")
+                    topic = body[2:2 + tlen]
+                    pos = 2 + tlen
+                    if qos:
+                        pid = body[pos:pos + 2]
+                        pos += 2
+                        self._send(conn, _packet(0x40, pid))
+                    payload = body[pos:]
+                    with self.lock:
+                        self.publishes += 1
+                        if header & 0x01:
+                            self.retained[topic] = payload
+                        targets = [c for c, fl in self.subs.items()
+                                   if any(_topic_matches(f, topic) for f in fl)]
+                    for c in targets:
+                        self._deliver(c, topic, payload)
+                elif kind == 8:                             # SUBSCRIBE
+                    pid, pos, granted, filters = body[:2], 2, b"", []
+                    while pos < len(body):
+                        flen = int.from_bytes(body[pos:pos + 2], "big")
+                        filters.append(body[pos + 2:pos + 2 + flen])
+                        granted += bytes([min(body[pos + 2 + flen], 1)])
+                        pos += 3 + flen
+                    with self.lock:
+                        self.subs.setdefault(conn, []).extend(filters)
+                        retained = [(t, p) for t, p in self.retained.items()
+                                    if any(_topic_matches(f, t) for f in filters)]
+                    self._send(conn, _packet(0x90, pid + granted))
+                    for t, p in retained:
+                        self._deliver(conn, t, p, retain=True)
+                elif kind == 10:                            # UNSUBSCRIBE
+                    self._send(conn, _packet(0xB0, body[:2]))
+                elif kind == 12:                            # PINGREQ
+                    self._send(conn, _packet(0xD0, b""))
+                elif kind == 14:                            # DISCONNECT
+                    break
+        except (ConnectionError, OSError):
+            pass
+        finally:
+            with self.lock:
+                self.subs.pop(conn, None)
+            conn.close()
+
+
+# --------------------------------------------------------------------------
+# Impairment proxy
+# --------------------------------------------------------------------------
+
+
+class ImpairProxy:
+    """
+    One-way delay + jitter applied to every chunk in both directions. TCP never
+    loses bytes end to end, so loss is modelled as what the device observes:
+    with probability `loss` a chunk is held for an extra retransmission timeout.
+    Ordering inside a direction is preserved.
+    """
+
+    def __init__(self, upstream, delay_ms, jitter_ms, loss, rto_ms, seed):
+        self.upstream = upstream
+        self.delay = delay_ms / 1000.0
+        self.jitter = jitter_ms / 1000.0
+        self.loss = loss
+        self.rto = rto_ms / 1000.0
+        self.rng = random.Random(seed)
+        self.rng_lock = threading.Lock()
+        self.srv = socket.socket(socket.AF_INET, socket.SOCK_STREAM)
+        self.srv.setsockopt(socket.SOL_SOCKET, socket.SO_REUSEADDR, 1)
+        self.srv.bind(("127.0.0.1", 0))
+        self.srv.listen(16)
+        self.port = self.srv.getsockname()[1]
+        self.lost = 0
+
+    def start(self):
+        threading.Thread(target=self._accept, daemon=True).start()
+        return self
+
+    def _accept(self):
+        while True:
+            down, _ = self.srv.accept()
+            try:
+                up = socket.create_connection(self.upstream)
+            except OSError:
+                down.close()
+                continue
+            for s in (down, up):
+                s.setsockopt(socket.IPPROTO_TCP, socket.TCP_NODELAY, 1)
+            self._pipe(down, up)
+            self._pipe(up, down)
+
+    def _extra_delay(self):
+        with self.rng_lock:
+            d = self.delay + (self.rng.uniform(-self.jitter, self.jitter) if self.jitter else 0.0)
+            if self.loss and self.rng.random() < self.loss:
+                self.lost += 1
+                d += self.rto
+        return max(d, 0.0)
+
+    def _pipe(self, src, dst):
+        queue, cond = [], threading.Condition()
+
+        def reader():
+            last_due = 0.0
+            while True:
+                try:
+                    data = src.recv(65536)
+                except OSError:
+                    data = b""
+                due = max(time.monotonic() + self._extra_delay(), last_due)
+                last_due = due
+                with cond:
+                    queue.append((due, data))
+                    cond.notify()
+                if not data:
+                    return
+
+        def writer():
+            while True:
+                with cond:
+                    while not queue:
+                        cond.wait()
+                    due, data = queue.pop(0)
+                wait = due - time.monotonic()
+                if wait > 0:
+                    time.sleep(wait)
+                if not data:
+                    try:
+                        dst.shutdown(socket.SHUT_WR)
+                    except OSError:
+                        pass
+                    return
+                try:
+                    dst.sendall(data)
+                except OSError:
+                    return
+
+        threading.Thread(target=reader, daemon=True).start()
+        threading.Thread(target=writer, daemon=True).start()
+
+
+# --------------------------------------------------------------------------
+# Runner
+# --------------------------------------------------------------------------
+
+PHASES = ("connect_us", "subscribe_us", "publish_us", "disconnect_us", "total_us")
+
+
+def _pct(values, p):
+    s = sorted(values)
+    return s[min(len(s) - 1, int(round(p / 100.0 * (len(s) - 1))))]
+
+
+def summarise(results):
+    ok = [r for r in results if r["connected"]]
+    print("cycles: %d  connected: %d  subscribed: %d" %
+          (len(results), len(ok), sum(r["subscribed"] for r in results)))
+    if not ok:
+        return
+    print("%-14s %10s %10s %10s %10s" % ("phase [ms]", "mean", "p50", "p95", "max"))
+    for phase in PHASES:
+        v = [r[phase] / 1000.0 for r in ok]
+        print("%-14s %10.1f %10.1f %10.1f %10.1f" %
+              (phase[:-3], statistics.mean(v), _pct(v, 50), _pct(v, 95), max(v)))
+    print("bytes/cycle    sent %.0f  received %.0f" %
+          (statistics.mean(r["bytes_sent"] for r in ok),
+           statistics.mean(r["bytes_received"] for r in ok)))
+    last = results[-1]
+    print("inbound queue  delivered %d  high watermark %d  dropped %d  rejected %d  streamed %d bytes" %
+          (last["inbound_delivered"], last["inbound_high_watermark"],
+           last["inbound_dropped"], last["inbound_rejected"], last["streamed_bytes"]))
+
+
+def main():
+    ap = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    ap.add_argument("-n", "--cycles", type=int, default=20)
+    ap.add_argument("--broker", help="host:port of an external broker (default: built-in)")
+    ap.add_argument("--retain-interval", default="60",
+                    help="retained payload on the interval topic for the built-in broker ('' = none)")
+    ap.add_argument("--retain-bytes", type=int, default=0,
+                    help="pad the retained interval payload to this size (exercises streamed delivery)")
+    ap.add_argument("--delay-ms", type=float, default=0.0, help="one-way latency added per chunk")
+    ap.add_argument("--jitter-ms", type=float, default=0.0, help="uniform +/- jitter on the delay")
+    ap.add_argument("--loss", type=float, default=0.0, help="probability a chunk needs a retransmission")
+    ap.add_argument("--rto-ms", type=float, default=1000.0, help="stall added for a lost chunk")
+    ap.add_argument("--seed", type=int, default=1)
+    ap.add_argument("--yield-ms", type=int, default=0,
+                    help="MQTTYield() after SUBSCRIBE so retained messages go through the inbound queue")
+    ap.add_argument("--json", action="store_true", help="dump raw BENCH records as JSON")
+    ap.add_argument("--bin", default=BENCH_BIN)
+    args = ap.parse_args()
+
+    if not os.path.exists(args.bin):
+        sys.exit("%s not found, run make first" % args.bin)
+
+    if args.broker:
+        host, _, port = args.broker.rpartition(":")
+        upstream = (host, int(port))
+    else:
+        broker = MiniBroker().start()
+        if args.retain_interval:
+            payload = args.retain_interval.encode()
+            broker.retain(INTERVAL_TOPIC.encode(), payload + b" " * max(0, args.retain_bytes - len(payload)))
+        upstream = ("127.0.0.1", broker.port)
+
+    target = upstream
+    proxy = None
+    if args.delay_ms or args.jitter_ms or args.loss:
+        proxy = ImpairProxy(upstream, args.delay_ms, args.jitter_ms, args.loss, args.rto_ms, args.seed).start()
+        target = ("127.0.0.1", proxy.port)
+
+    cmd = [args.bin, "-h", target[0], "-p", str(target[1]), "-n", str(args.cycles),
+           "-i", "bench-%d" % os.getpid(), "-y", str(args.yield_ms)]
+    proc = subprocess.run(cmd, stdout=subprocess.PIPE, stderr=subprocess.STDOUT, text=True)
+
+    results = [json.loads(line[6:]) for line in proc.stdout.splitlines() if line.startswith("BENCH ")]
+    if proc.returncode != 0 or not results:
+        sys.stdout.write(proc.stdout)
+        sys.exit("mqtt_host_bench exited with %d" % proc.returncode)
+
+    if args.json:
+        json.dump(results, sys.stdout, indent=1)
+        print()
+    summarise(results)
+    if proxy:
+        print("impairment     delay %.0f ms  jitter %.0f ms  loss %.3f (stalls: %d)" %
+              (args.delay_ms, args.jitter_ms, args.loss, proxy.lost))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,154 @@
+#   _    _ _______   __  __ _____ _____ _____   ____  _   _
+#  | |  | |__   __| |  \/  |_   _/ ____|  __ \ / __ \| \ | |
+#  | |__| |  | |    | \  / | | || |    | |__) | |  | |  \| |
+#  |  __  |  | |    | |\/| | | || |    |  _  /| |  | | . ` |
+#  | |  | |  | |    | |  | |_| || |____| | \ \| |__| | |\  |
+#  |_|  |_|  |_|    |_|  |_|_____\_____|_|  \_\\____/|_| \_|
+#  =================== Advanced R&D ========================
+
+#  Copyright (c) 2023 HT Micron Semicondutores S.A.
+#  Licensed under the Apache License, Version 2.0 (the "License");
+#  you may not use this file except in compliance with the License.
+#  You may obtain a copy of the License at
+#  http://www.apache.org/licenses/LICENSE-2.0
+#  Unless required by applicable law or agreed to in writing, software
+#  distributed under the License is distributed on an "AS IS" BASIS,
+#  WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+#  See the License for the specific language governing permissions and
+#  limitations under the License.
+
+# file: trust_store.py
+# brief: Builds the factory image of the TLS trust store (HT_TrustStore.h):
+#        the header followed by the DER items, ready to be written by the
+#        flash tool at FLASH_TRUST_STORE_START (0x320000, XIP 0x00B20000).
+# link: https://github.com/htmicron
+# version: 0.1
+#
+# python3 trust_store.py -o trust_store.bin --ca ca.pem --cert device.pem \
+#         --key device.key --pin-cert server.pem
+#
+# Every option is optional; PEM or DER files are accepted. The firmware reads
+# the store through HT_TrustStore_Get() and uses it on the next connect.
+
+import argparse
+import base64
+import hashlib
+import struct
+import sys
+
+MAGIC = 0x53545448              # HT_TRUST_STORE_MAGIC, "HTTS"
+VERSION = 1                     # HT_TRUST_STORE_VERSION
+MAX_ITEMS = 4                   # HT_TRUST_STORE_MAX_ITEMS
+AREA_LEN = 0x4000               # FLASH_TRUST_STORE_LEN
+PIN_LEN = 32                    # HT_TRUST_PIN_LEN
+
+# HT_TrustType
+CA_CERT, CLIENT_CERT, CLIENT_KEY, SERVER_PINS = 1, 2, 3, 4
+
+# HT_TrustStoreHeader_t: magic, version, count, entry[MAX_ITEMS] {type, offset, len}, sha256
+ENTRY = struct.Struct("<III")
+HEADER_LEN = 8 + ENTRY.size * MAX_ITEMS + 32
+
+
+def read_der(path):
+    # Same conversion as HT_TrustStore_WritePem(): every PEM block decoded and concatenated
+    data = open(path, "rb").read()
+    if not data.lstrip().startswith(b"-----BEGIN"):
+        return data
+
+    der, block = b"", None
+    for line in data.splitlines():
+        line = line.strip()
+        if line.startswith(b"-----BEGIN"):
+            block = b""
+        elif line.startswith(b"-----END"):
+            if block is None:
+                sys.exit("{}: END sem BEGIN".format(path))
+            der += base64.b64decode(block)
+            block = None
+        elif block is not None:
+            if b":" in line:
+                sys.exit("{}: PEM com cabecalhos (chave cifrada?) nao e aceito".format(path))
+            block += line
+    if block is not None or not der:
+        sys.exit("{}: PEM incompleto".format(path))
+    return der
+
+
+def der_tlv(buf, pos):
+    # Returns (tag, start of the value, end of the value) of the DER element at pos
+    tag, n = buf[pos], buf[pos + 1]
+    pos += 2
+    if n & 0x80:
+        count = n & 0x7F
+        n = int.from_bytes(buf[pos:pos + count], "big")
+        pos += count
+    return tag, pos, pos + n
+
+
+def spki_pin(cert):
+    # SHA-256 of the SubjectPublicKeyInfo, the value the verify callback of HT_MQTT_Tls.c compares
+    _, pos, _ = der_tlv(cert, 0)                # Certificate
+    _, pos, _ = der_tlv(cert, pos)              # tbsCertificate
+    if cert[pos] == 0xA0:                       # [0] version
+        pos = der_tlv(cert, pos)[2]
+    for _ in range(5):                          # serial, signature, issuer, validity, subject
+        pos = der_tlv(cert, pos)[2]
+    tag, _, end = der_tlv(cert, pos)
+    if tag != 0x30:
+        sys.exit("certificado sem SubjectPublicKeyInfo")
+    return hashlib.sha256(cert[pos:end]).digest()
+
+
+def build(items):
+    entries, data = [], b""
+    for item_type, item in items:
+        entries.append(ENTRY.pack(item_type, HEADER_LEN + len(data), len(item)))
+        data += item
+    entries += [ENTRY.pack(0, 0, 0)] * (MAX_ITEMS - len(entries))
+    entries = b"".join(entries)
+
+    if HEADER_LEN + len(data) > AREA_LEN:
+        sys.exit("trust store com {} bytes, a area tem {}".format(HEADER_LEN + len(data), AREA_LEN))
+
+    # HT_TrustStore_Digest(): SHA-256 of entry[] followed by the SHA-256 of the items
+    digest = hashlib.sha256(entries + hashlib.sha256(data).digest()).digest()
+    return struct.pack("<IHH", MAGIC, VERSION, len(items)) + entries + digest + data
+
+
+def main():
+    parser = argparse.ArgumentParser(description="Imagem do trust store TLS para a flash")
+    parser.add_argument("-o", "--output", required=True, help="imagem gerada (.bin)")
+    parser.add_argument("--ca", help="certificados da CA, PEM ou DER")
+    parser.add_argument("--cert", help="certificado do dispositivo, PEM ou DER")
+    parser.add_argument("--key", help="chave privada do dispositivo, PEM ou DER, sem cifra")
+    parser.add_argument("--pin-cert", action="append", default=[],
+                        help="certificado do servidor cuja chave publica e fixada (repetivel)")
+    parser.add_argument("--pin", action="append", default=[],
+                        help="SHA-256 de um SubjectPublicKeyInfo, em hexadecimal (repetivel)")
+    args = parser.parse_args()
+
+    items = []
+    if args.ca:
+        items.append((CA_CERT, read_der(args.ca)))
+    if args.cert:
+        items.append((CLIENT_CERT, read_der(args.cert)))
+    if args.key:
+        items.append((CLIENT_KEY, read_der(args.key)))
+
+    pins = [spki_pin(read_der(p)) for p in args.pin_cert] + [bytes.fromhex(p) for p in args.pin]
+    if any(len(p) != PIN_LEN for p in pins):
+        sys.exit("pin deve ter {} bytes".format(PIN_LEN))
+    if pins:
+        items.append((SERVER_PINS, b"".join(pins)))
+
+    if not items:
+        sys.exit("nenhum item: use --ca, --cert, --key, --pin-cert ou --pin")
+
+    image = build(items)
+    open(args.output, "wb").write(image)
+    print("{}: {} bytes, {} itens".format(args.output, len(image), len(items)))
+
+
+if __name__ == "__main__":
+    main()
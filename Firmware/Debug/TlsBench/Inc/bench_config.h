@@ -0,0 +1,43 @@
+/*!
+ * \file bench_config.h
+ * \brief MBEDTLS_CONFIG_FILE of the host benchmark: the device configuration
+ *        named by BENCH_TARGET_CONFIG plus the few changes a Linux build and
+ *        the in-process server need. Algorithms, curves and buffer sizes
+ *        stay exactly as on the device.
+ */
+
+#ifndef BENCH_CONFIG_H
+#define BENCH_CONFIG_H
+
+/* The device configurations enable MBEDTLS_THREADING_C for the FreeRTOS port,
+ * which has no Linux counterpart. Claiming an implementation keeps their
+ * check_config.h quiet; threading is dropped below, the bench is single threaded. */
+#define MBEDTLS_THREADING_IMPL
+
+#include BENCH_TARGET_CONFIG
+
+#undef MBEDTLS_THREADING_C
+#undef MBEDTLS_THREADING_IMPL
+
+/* Upstream sizes the output buffer like the input one when a configuration
+ * does not say; the SDK copy of ssl.h expects MBEDTLS_SSL_MAX_OUT_CONTENT_LEN */
+#if !defined(MBEDTLS_SSL_OUT_CONTENT_LEN) && !defined(MBEDTLS_SSL_MAX_OUT_CONTENT_LEN)
+#define MBEDTLS_SSL_OUT_CONTENT_LEN MBEDTLS_SSL_MAX_CONTENT_LEN
+#endif
+
+/* timing_alt.h is part of the device port */
+#undef MBEDTLS_TIMING_ALT
+
+/* The server side of every handshake runs in the same process */
+#define MBEDTLS_SSL_SRV_C
+#if defined(MBEDTLS_SSL_PROTO_DTLS) && defined(MBEDTLS_SSL_DTLS_HELLO_VERIFY)
+#define MBEDTLS_SSL_COOKIE_C
+#endif
+
+/* X25519 from the HACL* code in 3rdparty/everest instead of the generic ECP module */
+#if defined(BENCH_EVEREST)
+#undef MBEDTLS_ECDH_LEGACY_CONTEXT
+#define MBEDTLS_ECDH_VARIANT_EVEREST_ENABLED
+#endif
+
+#endif /* BENCH_CONFIG_H */
@@ -0,0 +1,522 @@
+/*!
+ * \file tls_bench.c
+ * \brief Full client handshakes against an in-process server, built once per
+ *        device mbedTLS configuration (see Inc/bench_config.h). For every
+ *        key exchange the configuration supports it reports the bytes each
+ *        side puts on the wire, the round trips and the client CPU time,
+ *        scaled to a Cortex-M3 estimate.
+ *
+ * The client is set up like HT_MQTT_Tls.c: max fragment length 1024, the CA
+ * checked, PSK identity and key of the sizes the device uses. Both ends talk
+ * through memory pipes, so only the client steps are timed and the counts
+ * are exact: bytes are TLS/DTLS record bytes, without TCP/UDP/IP headers.
+ *
+ * The Cortex-M3 figure is host cycles x ratio. The default ratio is rough
+ * (64-bit limbs and a wide core on the host, 32-bit UMULL at about one
+ * instruction per cycle on the device); calibrate it against one on-device
+ * HT_MQTT_TLSGetProfile() before trusting absolute times. Relative costs
+ * between profiles hold without calibration.
+ *
+ * Usage: tls_bench [-n handshakes] [-r m3_ratio] [-m m3_mhz] [-c host_mhz]
+ */
+
+#include <getopt.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <sys/random.h>
+
+#include "mbedtls/ssl.h"
+#include "mbedtls/ssl_ciphersuites.h"
+#include "mbedtls/ctr_drbg.h"
+#include "mbedtls/ecp.h"
+#if defined(MBEDTLS_SSL_COOKIE_C)
+#include "mbedtls/ssl_cookie.h"
+#endif
+#if defined(MBEDTLS_CERTS_C)
+#include "mbedtls/certs.h"
+#endif
+
+#if defined(MBEDTLS_X509_CRT_PARSE_C) && defined(MBEDTLS_PK_PARSE_C) && defined(MBEDTLS_CERTS_C)
+#define BENCH_HAVE_CERTS
+#endif
+
+#define BENCH_PIPE_LEN      (32 * 1024)
+#define BENCH_MAX_DGRAMS    64
+#define BENCH_MAX_STEPS     1000
+
+#define BENCH_CLIENT        1
+#define BENCH_SERVER        2
+
+typedef enum {
+    BENCH_AUTH_PSK = 0,
+    BENCH_AUTH_EC,
+    BENCH_AUTH_RSA
+} BenchAuth;
+
+typedef struct {
+    const char *name;
+    int suite;
+    BenchAuth auth;
+    mbedtls_ecp_group_id curve;             /**</ Key exchange curve, MBEDTLS_ECP_DP_NONE without ECDHE. */
+} BenchProfile;
+
+typedef struct {
+    unsigned char buf[BENCH_PIPE_LEN];
+    size_t used;
+    size_t dgram[BENCH_MAX_DGRAMS];         /**</ Datagram boundaries, DTLS only. */
+    int dgrams;
+} BenchPipe;
+
+typedef struct {
+    BenchPipe to_server;
+    BenchPipe to_client;
+    int datagram;
+    int last_writer;
+    size_t tx_bytes;                        /**</ Client to server. */
+    size_t rx_bytes;                        /**</ Server to client. */
+    unsigned tx_writes;
+    unsigned rx_writes;
+    unsigned round_trips;                   /**</ Server flights, each one answers a client flight. */
+} BenchLink;
+
+typedef struct {
+    BenchLink *link;
+    int who;
+} BenchEnd;
+
+typedef struct {
+    int ret;
+    size_t tx_bytes;
+    size_t rx_bytes;
+    unsigned tx_writes;
+    unsigned rx_writes;
+    unsigned round_trips;
+    uint64_t client_ns;
+    uint64_t server_ns;
+} BenchResult;
+
+static const BenchProfile profiles[] = {
+    { "ECDHE-ECDSA P-256 GCM",   MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256, BENCH_AUTH_EC,  MBEDTLS_ECP_DP_SECP256R1 },
+    { "ECDHE-ECDSA X25519 GCM",  MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_GCM_SHA256, BENCH_AUTH_EC,  MBEDTLS_ECP_DP_CURVE25519 },
+    { "ECDHE-ECDSA P-256 CCM-8", MBEDTLS_TLS_ECDHE_ECDSA_WITH_AES_128_CCM_8,      BENCH_AUTH_EC,  MBEDTLS_ECP_DP_SECP256R1 },
+    { "ECDHE-RSA P-256 GCM",     MBEDTLS_TLS_ECDHE_RSA_WITH_AES_128_GCM_SHA256,   BENCH_AUTH_RSA, MBEDTLS_ECP_DP_SECP256R1 },
+    { "RSA-2048 GCM",            MBEDTLS_TLS_RSA_WITH_AES_128_GCM_SHA256,         BENCH_AUTH_RSA, MBEDTLS_ECP_DP_NONE },
+    { "ECDHE-PSK P-256 CBC",     MBEDTLS_TLS_ECDHE_PSK_WITH_AES_128_CBC_SHA256,   BENCH_AUTH_PSK, MBEDTLS_ECP_DP_SECP256R1 },
+    { "PSK CCM-8",               MBEDTLS_TLS_PSK_WITH_AES_128_CCM_8,              BENCH_AUTH_PSK, MBEDTLS_ECP_DP_NONE },
+    { "PSK GCM",                 MBEDTLS_TLS_PSK_WITH_AES_128_GCM_SHA256,         BENCH_AUTH_PSK, MBEDTLS_ECP_DP_NONE },
+};
+
+/* Sizes of the device credentials: 8 character identity, 128-bit key */
+static const unsigned char pskIdentity[] = "sensor03";
+static const unsigned char pskKey[16] = {
+    0x00, 0x11, 0x22, 0x33, 0x44, 0x55, 0x66, 0x77, 0x88, 0x99, 0xaa, 0xbb, 0xcc, 0xdd, 0xee, 0xff
+};
+
+static mbedtls_ctr_drbg_context drbg;
+#if defined(MBEDTLS_SSL_COOKIE_C)
+static mbedtls_ssl_cookie_ctx cookie;
+#endif
+#if defined(BENCH_HAVE_CERTS)
+static mbedtls_x509_crt caEc, caRsa, srvCrtEc, srvCrtRsa;
+static mbedtls_pk_context srvKeyEc, srvKeyRsa;
+static int certsOk = 0;
+#endif
+
+static BenchLink benchLink;
+
+/* --- Transport ------------------------------------------------------------ */
+
+static int Bench_Send(void *ctx, const unsigned char *buf, size_t len) {
+    BenchEnd *end = (BenchEnd *)ctx;
+    BenchLink *l = end->link;
+    BenchPipe *pipe = (end->who == BENCH_CLIENT) ? &l->to_server : &l->to_client;
+
+    if (pipe->used + len > sizeof(pipe->buf) || (l->datagram && pipe->dgrams == BENCH_MAX_DGRAMS))
+        return MBEDTLS_ERR_SSL_WANT_WRITE;
+
+    memcpy(pipe->buf + pipe->used, buf, len);
+    pipe->used += len;
+    if (l->datagram)
+        pipe->dgram[pipe->dgrams++] = len;
+
+    if (end->who != l->last_writer) {
+        if (end->who == BENCH_SERVER)
+            l->round_trips++;
+        l->last_writer = end->who;
+    }
+
+    if (end->who == BENCH_CLIENT) {
+        l->tx_bytes += len;
+        l->tx_writes++;
+    } else {
+        l->rx_bytes += len;
+        l->rx_writes++;
+    }
+
+    return (int)len;
+}
+
+static int Bench_Recv(void *ctx, unsigned char *buf, size_t len) {
+    BenchEnd *end = (BenchEnd *)ctx;
+    BenchLink *l = end->link;
+    BenchPipe *pipe = (end->who == BENCH_CLIENT) ? &l->to_client : &l->to_server;
+    size_t avail, copy;
+
+    if (pipe->used == 0)
+        return MBEDTLS_ERR_SSL_WANT_READ;
+
+    // A datagram is consumed whole even when buf is shorter, like a UDP socket
+    avail = l->datagram ? pipe->dgram[0] : pipe->used;
+    copy = (len < avail) ? len : avail;
+    memcpy(buf, pipe->buf, copy);
+
+    if (l->datagram) {
+        memmove(pipe->dgram, pipe->dgram + 1, (size_t)(--pipe->dgrams) * sizeof(pipe->dgram[0]));
+    } else {
+        avail = copy;
+    }
+    memmove(pipe->buf, pipe->buf + avail, pipe->used - avail);
+    pipe->used -= avail;
+
+    return (int)copy;
+}
+
+/* Nothing is lost in memory: the DTLS retransmission timer never expires */
+static void Bench_TimerSet(void *ctx, uint32_t int_ms, uint32_t fin_ms) {
+    (void)int_ms;
+    *(int *)ctx = (fin_ms != 0);
+}
+
+static int Bench_TimerGet(void *ctx) {
+    return *(int *)ctx ? 0 : -1;
+}
+
+/* --- Host services --------------------------------------------------------- */
+
+static int Bench_Entropy(void *ctx, unsigned char *out, size_t len) {
+    (void)ctx;
+
+    return (getrandom(out, len, 0) == (ssize_t)len) ? 0 : MBEDTLS_ERR_CTR_DRBG_ENTROPY_SOURCE_FAILED;
+}
+
+#if defined(MBEDTLS_ENTROPY_HARDWARE_ALT)
+/* The device TRNG port is not built on the host */
+int mbedtls_hardware_poll(void *data, unsigned char *output, size_t len, size_t *olen) {
+    *olen = 0;
+    if (Bench_Entropy(data, output, len) != 0)
+        return -1;
+    *olen = len;
+
+    return 0;
+}
+#endif
+
+static uint64_t Bench_CpuNs(void) {
+    struct timespec ts;
+
+    clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000u + (uint64_t)ts.tv_nsec;
+}
+
+static double Bench_HostMhz(void) {
+    FILE *f = fopen("/proc/cpuinfo", "r");
+    char line[256];
+    double mhz = 0;
+
+    if (f == NULL)
+        return 3000;
+
+    while (fgets(line, sizeof(line), f) != NULL)
+        if (sscanf(line, "cpu MHz : %lf", &mhz) == 1)
+            break;
+    fclose(f);
+
+    return (mhz > 0) ? mhz : 3000;
+}
+
+/* --- Handshake ------------------------------------------------------------- */
+
+#if defined(BENCH_HAVE_CERTS)
+static void Bench_LoadCerts(void) {
+    mbedtls_x509_crt_init(&caEc);
+    mbedtls_x509_crt_init(&caRsa);
+    mbedtls_x509_crt_init(&srvCrtEc);
+    mbedtls_x509_crt_init(&srvCrtRsa);
+    mbedtls_pk_init(&srvKeyEc);
+    mbedtls_pk_init(&srvKeyRsa);
+
+    // A missing algorithm only disables the profiles that need it
+    certsOk = 0;
+    if (mbedtls_x509_crt_parse(&caEc, (const unsigned char *)mbedtls_test_ca_crt_ec, mbedtls_test_ca_crt_ec_len) == 0 &&
+        mbedtls_x509_crt_parse(&srvCrtEc, (const unsigned char *)mbedtls_test_srv_crt_ec, mbedtls_test_srv_crt_ec_len) == 0 &&
+        mbedtls_pk_parse_key(&srvKeyEc, (const unsigned char *)mbedtls_test_srv_key_ec, mbedtls_test_srv_key_ec_len, NULL, 0) == 0)
+        certsOk |= 1 << BENCH_AUTH_EC;
+
+    if (mbedtls_x509_crt_parse(&caRsa, (const unsigned char *)mbedtls_test_ca_crt_rsa, mbedtls_test_ca_crt_rsa_len) == 0 &&
+        mbedtls_x509_crt_parse(&srvCrtRsa, (const unsigned char *)mbedtls_test_srv_crt_rsa, mbedtls_test_srv_crt_rsa_len) == 0 &&
+        mbedtls_pk_parse_key(&srvKeyRsa, (const unsigned char *)mbedtls_test_srv_key_rsa, mbedtls_test_srv_key_rsa_len, NULL, 0) == 0)
+        certsOk |= 1 << BENCH_AUTH_RSA;
+}
+#endif
+
+static const char *Bench_Supported(const BenchProfile *p) {
+    if (mbedtls_ssl_ciphersuite_from_id(p->suite) == NULL)
+        return "suite not built";
+
+#if defined(MBEDTLS_ECP_C)
+    if (p->curve != MBEDTLS_ECP_DP_NONE && mbedtls_ecp_curve_info_from_grp_id(p->curve) == NULL)
+        return "curve not built";
+#else
+    if (p->curve != MBEDTLS_ECP_DP_NONE)
+        return "no ECP";
+#endif
+
+    if (p->auth != BENCH_AUTH_PSK) {
+#if defined(BENCH_HAVE_CERTS)
+        if (!(certsOk & (1 << p->auth)))
+            return "test certificate not usable";
+#else
+        return "no X.509 or test certificates";
+#endif
+    }
+
+    return NULL;
+}
+
+static int Bench_Configure(mbedtls_ssl_config *conf, int endpoint, int transport, const BenchProfile *p,
+                           const int *suites, const mbedtls_ecp_group_id *curves) {
+    int ret;
+
+    if ((ret = mbedtls_ssl_config_defaults(conf, endpoint, transport, MBEDTLS_SSL_PRESET_DEFAULT)) != 0)
+        return ret;
+
+    mbedtls_ssl_conf_rng(conf, mbedtls_ctr_drbg_random, &drbg);
+    mbedtls_ssl_conf_ciphersuites(conf, suites);
+#if defined(MBEDTLS_ECP_C)
+    if (p->curve != MBEDTLS_ECP_DP_NONE)
+        mbedtls_ssl_conf_curves(conf, curves);
+#else
+    (void)curves;
+#endif
+
+#if defined(MBEDTLS_KEY_EXCHANGE_SOME_PSK_ENABLED)
+    if (p->auth == BENCH_AUTH_PSK &&
+        (ret = mbedtls_ssl_conf_psk(conf, pskKey, sizeof(pskKey), pskIdentity, sizeof(pskIdentity) - 1)) != 0)
+        return ret;
+#endif
+
+#if defined(BENCH_HAVE_CERTS)
+    if (p->auth != BENCH_AUTH_PSK) {
+        if (endpoint == MBEDTLS_SSL_IS_CLIENT) {
+            mbedtls_ssl_conf_ca_chain(conf, (p->auth == BENCH_AUTH_EC) ? &caEc : &caRsa, NULL);
+            mbedtls_ssl_conf_authmode(conf, MBEDTLS_SSL_VERIFY_REQUIRED);
+        } else if ((ret = mbedtls_ssl_conf_own_cert(conf, (p->auth == BENCH_AUTH_EC) ? &srvCrtEc : &srvCrtRsa,
+                                                    (p->auth == BENCH_AUTH_EC) ? &srvKeyEc : &srvKeyRsa)) != 0) {
+            return ret;
+        }
+    }
+#endif
+
+    if (endpoint == MBEDTLS_SSL_IS_CLIENT) {
+#if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
+        // Same request as HT_MQTT_TLS_MAX_FRAG_LEN on the device
+        if ((ret = mbedtls_ssl_conf_max_frag_len(conf, MBEDTLS_SSL_MAX_FRAG_LEN_1024)) != 0)
+            return ret;
+#endif
+    }
+#if defined(MBEDTLS_SSL_PROTO_DTLS) && defined(MBEDTLS_SSL_DTLS_HELLO_VERIFY)
+    else if (transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM) {
+        // HelloVerifyRequest is what a production DTLS server sends: it costs a round trip
+#if defined(MBEDTLS_SSL_COOKIE_C)
+        mbedtls_ssl_conf_dtls_cookies(conf, mbedtls_ssl_cookie_write, mbedtls_ssl_cookie_check, &cookie);
+#endif
+    }
+#endif
+
+    return 0;
+}
+
+static void Bench_Handshake(const BenchProfile *p, int transport, BenchResult *r) {
+    static const unsigned char transportId[] = "127.0.0.1:5684";
+    int suites[2] = { p->suite, 0 };
+    mbedtls_ecp_group_id curves[2] = { p->curve, MBEDTLS_ECP_DP_NONE };
+    mbedtls_ssl_config cconf, sconf;
+    mbedtls_ssl_context cli, srv;
+    BenchEnd clientEnd = { &benchLink, BENCH_CLIENT }, serverEnd = { &benchLink, BENCH_SERVER };
+    int ctimer = 0, stimer = 0;
+    uint64_t t;
+    int steps = 0;
+    int ret;
+
+    memset(r, 0, sizeof(*r));
+    memset(&benchLink, 0, sizeof(benchLink));
+    benchLink.datagram = (transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM);
+
+    mbedtls_ssl_config_init(&cconf);
+    mbedtls_ssl_config_init(&sconf);
+    mbedtls_ssl_init(&cli);
+    mbedtls_ssl_init(&srv);
+
+    if ((ret = Bench_Configure(&cconf, MBEDTLS_SSL_IS_CLIENT, transport, p, suites, curves)) != 0 ||
+        (ret = Bench_Configure(&sconf, MBEDTLS_SSL_IS_SERVER, transport, p, suites, curves)) != 0 ||
+        (ret = mbedtls_ssl_setup(&cli, &cconf)) != 0 ||
+        (ret = mbedtls_ssl_setup(&srv, &sconf)) != 0)
+        goto exit;
+
+#if defined(BENCH_HAVE_CERTS)
+    if (p->auth != BENCH_AUTH_PSK && (ret = mbedtls_ssl_set_hostname(&cli, "localhost")) != 0)
+        goto exit;
+#endif
+
+    mbedtls_ssl_set_bio(&cli, &clientEnd, Bench_Send, Bench_Recv, NULL);
+    mbedtls_ssl_set_bio(&srv, &serverEnd, Bench_Send, Bench_Recv, NULL);
+    if (benchLink.datagram) {
+        mbedtls_ssl_set_timer_cb(&cli, &ctimer, Bench_TimerSet, Bench_TimerGet);
+        mbedtls_ssl_set_timer_cb(&srv, &stimer, Bench_TimerSet, Bench_TimerGet);
+#if defined(MBEDTLS_SSL_DTLS_HELLO_VERIFY)
+        mbedtls_ssl_set_client_transport_id(&srv, transportId, sizeof(transportId) - 1);
+#endif
+    }
+
+    ret = 0;
+    while (cli.state != MBEDTLS_SSL_HANDSHAKE_OVER || srv.state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+        if (++steps > BENCH_MAX_STEPS) {
+            ret = -1;
+            break;
+        }
+
+        if (cli.state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+            t = Bench_CpuNs();
+            ret = mbedtls_ssl_handshake_step(&cli);
+            r->client_ns += Bench_CpuNs() - t;
+            if (ret != 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+                break;
+        }
+
+        if (srv.state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+            t = Bench_CpuNs();
+            ret = mbedtls_ssl_handshake_step(&srv);
+            r->server_ns += Bench_CpuNs() - t;
+#if defined(MBEDTLS_SSL_DTLS_HELLO_VERIFY)
+            // The server forgets the first ClientHello and waits for the one carrying the cookie
+            if (ret == MBEDTLS_ERR_SSL_HELLO_VERIFY_REQUIRED) {
+                mbedtls_ssl_session_reset(&srv);
+                mbedtls_ssl_set_client_transport_id(&srv, transportId, sizeof(transportId) - 1);
+                ret = 0;
+            }
+#endif
+            if (ret != 0 && ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE)
+                break;
+        }
+
+        ret = 0;
+    }
+
+exit:
+    r->ret = ret;
+    r->tx_bytes = benchLink.tx_bytes;
+    r->rx_bytes = benchLink.rx_bytes;
+    r->tx_writes = benchLink.tx_writes;
+    r->rx_writes = benchLink.rx_writes;
+    r->round_trips = benchLink.round_trips;
+
+    mbedtls_ssl_free(&cli);
+    mbedtls_ssl_free(&srv);
+    mbedtls_ssl_config_free(&cconf);
+    mbedtls_ssl_config_free(&sconf);
+    (void)transportId;
+}
+
+/* --- Main ------------------------------------------------------------------- */
+
+static void Bench_Run(const BenchProfile *p, int transport, int runs, double host_mhz, double m3_ratio, double m3_mhz) {
+    const char *tr = (transport == MBEDTLS_SSL_TRANSPORT_DATAGRAM) ? "dtls" : "tls";
+    const char *why = Bench_Supported(p);
+    BenchResult r;
+    uint64_t client_ns = 0;
+    double host_us, m3_mcycles;
+
+    if (why != NULL) {
+        printf("%-24s %-4s  -- %s\n", p->name, tr, why);
+        return;
+    }
+
+    for (int i = 0; i < runs; i++) {
+        Bench_Handshake(p, transport, &r);
+        if (r.ret != 0) {
+            printf("%-24s %-4s  -- handshake failed -0x%04x\n", p->name, tr, (unsigned)-r.ret);
+            return;
+        }
+        client_ns += r.client_ns;
+    }
+
+    host_us = (double)client_ns / runs / 1000.0;
+    m3_mcycles = host_us * host_mhz * m3_ratio / 1e6;
+
+    printf("%-24s %-4s %7zu %7zu %4u/%-4u %3u %9.0f %9.2f %8.0f\n", p->name, tr, r.tx_bytes, r.rx_bytes,
+           r.tx_writes, r.rx_writes, r.round_trips, host_us, m3_mcycles, m3_mcycles * 1000.0 / m3_mhz);
+}
+
+int main(int argc, char **argv) {
+    const char *pers = "tls_bench";
+    double host_mhz = Bench_HostMhz();
+    double m3_ratio = 10.0;
+    double m3_mhz = 204.0;
+    int runs = 5;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "n:r:m:c:")) != -1) {
+        switch (opt) {
+        case 'n': runs = atoi(optarg); break;
+        case 'r': m3_ratio = atof(optarg); break;
+        case 'm': m3_mhz = atof(optarg); break;
+        case 'c': host_mhz = atof(optarg); break;
+        default:
+            fprintf(stderr, "usage: %s [-n handshakes] [-r m3_ratio] [-m m3_mhz] [-c host_mhz]\n", argv[0]);
+            return 2;
+        }
+    }
+    if (runs < 1)
+        runs = 1;
+
+    mbedtls_ctr_drbg_init(&drbg);
+    if (mbedtls_ctr_drbg_seed(&drbg, Bench_Entropy, NULL, (const unsigned char *)pers, strlen(pers)) != 0) {
+        fprintf(stderr, "DRBG seed failed\n");
+        return 1;
+    }
+#if defined(MBEDTLS_SSL_COOKIE_C)
+    mbedtls_ssl_cookie_init(&cookie);
+    if (mbedtls_ssl_cookie_setup(&cookie, mbedtls_ctr_drbg_random, &drbg) != 0) {
+        fprintf(stderr, "DTLS cookie setup failed\n");
+        return 1;
+    }
+#endif
+#if defined(BENCH_HAVE_CERTS)
+    Bench_LoadCerts();
+#endif
+
+    printf("# %s%s, in/out content %d/%d B, %d handshakes, host %.0f MHz, M3 = host cycles x %.1f at %.0f MHz\n",
+           BENCH_TARGET_CONFIG,
+#if defined(MBEDTLS_ECDH_VARIANT_EVEREST_ENABLED)
+           " (everest)",
+#else
+           "",
+#endif
+           MBEDTLS_SSL_IN_CONTENT_LEN, MBEDTLS_SSL_OUT_CONTENT_LEN, runs, host_mhz, m3_ratio, m3_mhz);
+    printf("%-24s %-4s %7s %7s %9s %3s %9s %9s %8s\n", "profile", "tr", "c->s B", "s->c B", "writes", "rtt",
+           "host us", "M3 Mcyc", "M3 ms");
+
+    for (size_t i = 0; i < sizeof(profiles) / sizeof(profiles[0]); i++) {
+#if defined(MBEDTLS_SSL_PROTO_TLS1_2)
+        Bench_Run(&profiles[i], MBEDTLS_SSL_TRANSPORT_STREAM, runs, host_mhz, m3_ratio, m3_mhz);
+#endif
+#if defined(MBEDTLS_SSL_PROTO_DTLS)
+        Bench_Run(&profiles[i], MBEDTLS_SSL_TRANSPORT_DATAGRAM, runs, host_mhz, m3_ratio, m3_mhz);
+#endif
+    }
+
+    return 0;
+}
@@ -32,6 +32,12 @@
 
 /////////////////////////////////////////////////
 
+////////////////TRUST STORE AREA/////////////////
+#define FLASH_TRUST_STORE_START         0x320000
+#define FLASH_TRUST_STORE_LEN           0x4000                                            // 16KB, DER certificates and pins
+#define FLASH_TRUST_STORE_END           (FLASH_TRUST_STORE_START+FLASH_TRUST_STORE_LEN)
+/////////////////////////////////////////////////
+
 ////////////////FS AREA//////////////////////////
 #define FLASH_FS_REGION_OFFSET          0x350000
 #define FLASH_FS_REGION_END             0x3A4000
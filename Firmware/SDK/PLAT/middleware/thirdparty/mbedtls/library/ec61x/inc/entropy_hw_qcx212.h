@@ -0,0 +1,52 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * QCX212 TRNG as an mbedTLS entropy source. The prebuilt libmbedtls.a is
+ * configured without MBEDTLS_ENTROPY_HARDWARE_ALT, so the source is added
+ * to each entropy context at run time:
+ *
+ *     mbedtls_entropy_add_source( &entropy, qcx212_trng_poll, NULL,
+ *                                 QCX212_TRNG_THRESHOLD,
+ *                                 MBEDTLS_ENTROPY_SOURCE_STRONG );
+ */
+
+#ifndef ENTROPY_HW_QCX212_H
+#define ENTROPY_HW_QCX212_H
+
+#include "mbedtls/entropy.h"
+#include <stddef.h>
+
+/* The health tests assume 2 bits per byte: 128 bytes give the 256 bits a seed is credited with */
+#define QCX212_TRNG_THRESHOLD   128
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief   mbedtls_entropy_f_source_ptr reading the TRNG through the
+ *          repetition count and adaptive proportion tests. The first call
+ *          discards one test window. A failed test latches until reset.
+ *
+ * \return  0, or MBEDTLS_ERR_ENTROPY_SOURCE_FAILED with *olen set to 0.
+ */
+int qcx212_trng_poll( void *data, unsigned char *output, size_t len, size_t *olen );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* ENTROPY_HW_QCX212_H */
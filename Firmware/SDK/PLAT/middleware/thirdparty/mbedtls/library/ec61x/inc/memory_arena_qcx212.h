@@ -0,0 +1,92 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Dedicated mbedTLS heap. The prebuilt libmbedtls.a calls calloc() and
+ * free() directly (MBEDTLS_PLATFORM_CALLOC_MACRO in the SDK configuration),
+ * so the build links a copy of it whose references are renamed to
+ * qcx212_arena_calloc() and qcx212_arena_free() (HT_Prebuild/Makefile.inc).
+ * Handshakes are then served from a static arena instead of the system
+ * heap shared with FreeRTOS, lwIP and the application, and can no longer
+ * fragment it. Requests the arena cannot hold fall back to the system heap.
+ */
+
+#ifndef MEMORY_ARENA_QCX212_H
+#define MEMORY_ARENA_QCX212_H
+
+#include <stddef.h>
+#include <stdbool.h>
+
+/* Arena size in bytes; the TLS context with 4 KB records fits with room to spare */
+#if !defined(QCX212_ARENA_SIZE)
+#define QCX212_ARENA_SIZE   ( 40 * 1024 )
+#endif
+
+typedef struct
+{
+    size_t size;        /* Usable arena size */
+    size_t used;        /* Bytes allocated now, headers included */
+    size_t blocks;      /* Blocks allocated now */
+    size_t peak;        /* Highest use since qcx212_arena_peak_restart() */
+    size_t boot_peak;   /* Highest use since boot */
+}
+qcx212_arena_stats;
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * \brief   Formats the arena. Blocks allocated before come from the system
+ *          heap and are still freed there. Further calls do nothing.
+ */
+void qcx212_arena_init( void );
+
+/**
+ * \brief   Formats the arena back into a single free block in one step.
+ *          Only done when no block is allocated, i.e. after the last
+ *          mbedTLS context was freed.
+ *
+ * \return  true if the arena was reset.
+ */
+bool qcx212_arena_reset( void );
+
+/**
+ * \brief   calloc() of the redirected libmbedtls.a: from the arena once it
+ *          is formatted and has room, from the system heap otherwise.
+ */
+void *qcx212_arena_calloc( size_t n, size_t size );
+
+/**
+ * \brief   free() of the redirected libmbedtls.a, for blocks from either heap.
+ */
+void qcx212_arena_free( void *ptr );
+
+/**
+ * \brief   Starts a new peak measurement, e.g. at the start of a handshake.
+ */
+void qcx212_arena_peak_restart( void );
+
+/**
+ * \brief   Current use and peaks of the arena. All zero before
+ *          qcx212_arena_init().
+ */
+void qcx212_arena_get_stats( qcx212_arena_stats *stats );
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* MEMORY_ARENA_QCX212_H */
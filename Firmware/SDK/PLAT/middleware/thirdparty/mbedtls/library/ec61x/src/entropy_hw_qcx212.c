@@ -0,0 +1,136 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * Entropy source backed by the QCX212 TRNG, registered at run time with
+ * mbedtls_entropy_add_source() (see entropy_hw_qcx212.h). Every byte goes
+ * through the continuous health tests of NIST SP 800-90B section 4.4,
+ * sized for a conservative min-entropy estimate of 2 bits per byte and a
+ * false alarm rate of 2^-20.
+ */
+
+#if !defined(MBEDTLS_CONFIG_FILE)
+#include "mbedtls/config.h"
+#else
+#include MBEDTLS_CONFIG_FILE
+#endif
+
+#if defined(MBEDTLS_ENTROPY_C)
+
+#include "entropy_hw_qcx212.h"
+#include "mbedtls/platform_util.h"
+#include "bsp.h"
+#include "rng_qcx212.h"
+#include <stdbool.h>
+#include <string.h>
+
+#define TRNG_BLOCK_LEN      24          /* Bytes returned by RngGenRandom() */
+#define TRNG_RCT_CUTOFF     11          /* Repetition count test: 1 + ceil(20 / H) */
+#define TRNG_APT_WINDOW     512         /* Adaptive proportion test window, in samples */
+#define TRNG_APT_CUTOFF     177         /* Adaptive proportion test cutoff for H = 2, W = 512 */
+
+static struct
+{
+    bool started;
+    bool failed;
+    uint8_t rct_sample;
+    uint8_t rct_count;
+    uint8_t apt_sample;
+    uint16_t apt_count;
+    uint16_t apt_seen;
+} trng;
+
+static bool trng_health( uint8_t sample )
+{
+    if( trng.rct_count > 0 && sample == trng.rct_sample )
+    {
+        if( ++trng.rct_count >= TRNG_RCT_CUTOFF )
+            return( false );
+    }
+    else
+    {
+        trng.rct_sample = sample;
+        trng.rct_count = 1;
+    }
+
+    if( trng.apt_seen == 0 )
+    {
+        trng.apt_sample = sample;
+        trng.apt_count = 1;
+    }
+    else if( sample == trng.apt_sample && ++trng.apt_count >= TRNG_APT_CUTOFF )
+        return( false );
+
+    if( ++trng.apt_seen == TRNG_APT_WINDOW )
+        trng.apt_seen = 0;
+
+    return( true );
+}
+
+static int trng_block( uint8_t block[TRNG_BLOCK_LEN] )
+{
+    if( RngGenRandom( block ) != RNGDRV_OK )
+        return( -1 );
+
+    for( size_t i = 0; i < TRNG_BLOCK_LEN; i++ )
+        if( !trng_health( block[i] ) )
+            return( -1 );
+
+    return( 0 );
+}
+
+int qcx212_trng_poll( void *data, unsigned char *output, size_t len, size_t *olen )
+{
+    uint8_t block[TRNG_BLOCK_LEN];
+    size_t n;
+
+    ((void) data);
+    *olen = 0;
+
+    /* A failed health test latches until reset */
+    if( trng.failed )
+        return( MBEDTLS_ERR_ENTROPY_SOURCE_FAILED );
+
+    /* Start-up test: one full APT window is tested and discarded */
+    if( !trng.started )
+    {
+        for( n = 0; n < TRNG_APT_WINDOW; n += TRNG_BLOCK_LEN )
+            if( trng_block( block ) != 0 )
+                goto fail;
+        trng.started = true;
+    }
+
+    while( *olen < len )
+    {
+        if( trng_block( block ) != 0 )
+            goto fail;
+
+        n = ( len - *olen < TRNG_BLOCK_LEN ) ? len - *olen : TRNG_BLOCK_LEN;
+        memcpy( output + *olen, block, n );
+        *olen += n;
+    }
+
+    mbedtls_platform_zeroize( block, sizeof( block ) );
+    return( 0 );
+
+fail:
+    trng.failed = true;
+    mbedtls_platform_zeroize( block, sizeof( block ) );
+    mbedtls_platform_zeroize( output, *olen );
+    *olen = 0;
+    return( MBEDTLS_ERR_ENTROPY_SOURCE_FAILED );
+}
+
+#endif /* MBEDTLS_ENTROPY_C */
@@ -0,0 +1,231 @@
+/**
+ *
+ * Copyright (c) 2023 HT Micron Semicondutores S.A.
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ * http://www.apache.org/licenses/LICENSE-2.0
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ */
+
+/*
+ * First fit allocator over a static buffer. Blocks are contiguous and
+ * carry boundary tags: each header holds its own size and the size of the
+ * block before it, so a freed block merges with both neighbours at once
+ * and the arena never holds two adjacent free blocks.
+ */
+
+#include "memory_arena_qcx212.h"
+#include "FreeRTOS.h"
+#include "task.h"
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define ARENA_ALIGN         8
+#define ARENA_ROUND( n )    ( ( (n) + ARENA_ALIGN - 1 ) & ~(size_t)( ARENA_ALIGN - 1 ) )
+#define ARENA_LEN           ( QCX212_ARENA_SIZE & ~(size_t)( ARENA_ALIGN - 1 ) )
+#define ARENA_USED          ( (size_t) 1 )      /* In the size of an allocated block */
+
+typedef struct
+{
+    size_t size;        /* Block size, header included; ARENA_USED when allocated */
+    size_t prev;        /* Size of the previous block, 0 for the first one */
+}
+arena_hdr;
+
+#define ARENA_HDR           ARENA_ROUND( sizeof( arena_hdr ) )
+#define ARENA_MIN_SPLIT     ( ARENA_HDR + ARENA_ALIGN )
+#define ARENA_SIZE( h )     ( (h)->size & ~ARENA_USED )
+
+static unsigned char arena_buf[ARENA_LEN] __attribute__(( aligned( ARENA_ALIGN ) ));
+
+static struct
+{
+    bool ready;
+    size_t used;
+    size_t blocks;
+    size_t peak;
+    size_t boot_peak;
+} arena;
+
+static arena_hdr *arena_next( arena_hdr *h )
+{
+    unsigned char *next = (unsigned char *) h + ARENA_SIZE( h );
+
+    return( next < arena_buf + ARENA_LEN ? (arena_hdr *) next : NULL );
+}
+
+static void arena_format( void )
+{
+    arena_hdr *h = (arena_hdr *) arena_buf;
+
+    h->size = ARENA_LEN;
+    h->prev = 0;
+}
+
+static void *arena_alloc( size_t len )
+{
+    arena_hdr *h, *rest, *next;
+    size_t need, size;
+
+    if( len == 0 || len > ARENA_LEN - ARENA_HDR )
+        return( NULL );
+    need = ARENA_HDR + ARENA_ROUND( len );
+
+    for( h = (arena_hdr *) arena_buf; h != NULL; h = arena_next( h ) )
+    {
+        /* An allocated block has ARENA_USED set and never compares as free */
+        if( ( h->size & ARENA_USED ) || h->size < need )
+            continue;
+
+        size = h->size;
+        if( size - need >= ARENA_MIN_SPLIT )
+        {
+            rest = (arena_hdr *)( (unsigned char *) h + need );
+            rest->size = size - need;
+            rest->prev = need;
+            if( ( next = arena_next( rest ) ) != NULL )
+                next->prev = rest->size;
+            size = need;
+        }
+        h->size = size | ARENA_USED;
+
+        arena.used += size;
+        arena.blocks++;
+        if( arena.used > arena.peak )
+            arena.peak = arena.used;
+
+        return( (unsigned char *) h + ARENA_HDR );
+    }
+
+    return( NULL );
+}
+
+static void arena_release( unsigned char *p )
+{
+    arena_hdr *h = (arena_hdr *)( p - ARENA_HDR );
+    arena_hdr *next, *prev;
+    size_t size;
+
+    /* Double free */
+    if( !( h->size & ARENA_USED ) )
+        return;
+
+    size = ARENA_SIZE( h );
+    arena.used -= size;
+    arena.blocks--;
+
+    if( ( next = arena_next( h ) ) != NULL && !( next->size & ARENA_USED ) )
+        size += next->size;
+
+    if( h->prev != 0 )
+    {
+        prev = (arena_hdr *)( (unsigned char *) h - h->prev );
+        if( !( prev->size & ARENA_USED ) )
+        {
+            size += prev->size;
+            h = prev;
+        }
+    }
+
+    h->size = size;
+    if( ( next = arena_next( h ) ) != NULL )
+        next->prev = size;
+}
+
+static void arena_peak_fold( void )
+{
+    if( arena.peak > arena.boot_peak )
+        arena.boot_peak = arena.peak;
+}
+
+void qcx212_arena_init( void )
+{
+    vTaskSuspendAll();
+    if( !arena.ready )
+    {
+        arena_format();
+        arena.ready = true;
+    }
+    ( void ) xTaskResumeAll();
+}
+
+void *qcx212_arena_calloc( size_t n, size_t size )
+{
+    void *p = NULL;
+
+    if( n != 0 && size > SIZE_MAX / n )
+        return( NULL );
+
+    vTaskSuspendAll();
+    if( arena.ready )
+        p = arena_alloc( n * size );
+    ( void ) xTaskResumeAll();
+
+    if( p == NULL )
+        return( calloc( n, size ) );
+
+    memset( p, 0, n * size );
+    return( p );
+}
+
+void qcx212_arena_free( void *ptr )
+{
+    unsigned char *p = ptr;
+
+    if( p < arena_buf || p >= arena_buf + ARENA_LEN )
+    {
+        free( ptr );
+        return;
+    }
+
+    vTaskSuspendAll();
+    arena_release( p );
+    ( void ) xTaskResumeAll();
+}
+
+bool qcx212_arena_reset( void )
+{
+    bool reset = false;
+
+    vTaskSuspendAll();
+    if( arena.ready && arena.blocks == 0 )
+    {
+        arena_peak_fold();
+        arena_format();
+        reset = true;
+    }
+    ( void ) xTaskResumeAll();
+
+    return( reset );
+}
+
+void qcx212_arena_peak_restart( void )
+{
+    vTaskSuspendAll();
+    arena_peak_fold();
+    arena.peak = arena.used;
+    ( void ) xTaskResumeAll();
+}
+
+void qcx212_arena_get_stats( qcx212_arena_stats *stats )
+{
+    memset( stats, 0, sizeof( *stats ) );
+
+    if( !arena.ready )
+        return;
+
+    vTaskSuspendAll();
+    stats->size = ARENA_LEN;
+    stats->used = arena.used;
+    stats->blocks = arena.blocks;
+    stats->peak = arena.peak;
+    stats->boot_peak = ( arena.peak > arena.boot_peak ) ? arena.peak : arena.boot_peak;
+    ( void ) xTaskResumeAll();
+}
@@ -23,6 +23,12 @@
 #include "semphr.h"
 #include "task.h"
 
+/* The PS socket layer takes a Release Assistance Indication with the data:
+ * mqttwrite() gets it from MQTTSetReleaseAssist(). */
+#if ENABLE_PSIF && !defined(MQTT_RAI_OPTIMIZE)
+#define MQTT_RAI_OPTIMIZE
+#endif
+
 ///MQTT client results
 typedef enum {
     MQTT_CONN_OK = 0,        ///<Success
@@ -54,7 +60,11 @@ struct Network
 {
 	xSocket_t my_socket;
 	int (*mqttread) (Network*, unsigned char*, int, int);
+#ifdef MQTT_RAI_OPTIMIZE
+	int (*mqttwrite) (Network*, unsigned char*, int, int, unsigned char, bool);
+#else
 	int (*mqttwrite) (Network*, unsigned char*, int, int);
+#endif
 	int (*disconnect) (Network*);
 };
 
@@ -67,6 +77,7 @@ int TimerLeftMS(Timer*);
 typedef struct Mutex
 {
 	SemaphoreHandle_t sem;
+	StaticSemaphore_t semBuffer;
 } Mutex;
 
 void MutexInit(Mutex*);
@@ -81,7 +92,11 @@ typedef struct Thread
 int ThreadStart(Thread*, void (*fn)(void*), void* arg);
 
 int FreeRTOS_read(Network*, unsigned char*, int, int);
+#ifdef MQTT_RAI_OPTIMIZE
+int FreeRTOS_write(Network*, unsigned char*, int, int, unsigned char, bool);
+#else
 int FreeRTOS_write(Network*, unsigned char*, int, int);
+#endif
 int FreeRTOS_disconnect(Network*);
 
 void NetworkInit(Network*);
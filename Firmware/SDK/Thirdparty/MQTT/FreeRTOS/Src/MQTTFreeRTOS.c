@@ -37,7 +37,7 @@ int ThreadStart(Thread* thread, void (*fn)(void*), void* arg)
 
 void MutexInit(Mutex* mutex)
 {
-    mutex->sem = xSemaphoreCreateMutex();
+    mutex->sem = xSemaphoreCreateMutexStatic(&mutex->semBuffer);
 }
 
 int MutexLock(Mutex* mutex)
@@ -110,7 +110,11 @@ int FreeRTOS_read(Network* n, unsigned char* buffer, int len, int timeout_ms)
 }
 
 
+#ifdef MQTT_RAI_OPTIMIZE
+int FreeRTOS_write(Network* n, unsigned char* buffer, int len, int timeout_ms, unsigned char rai, bool exceptdata)
+#else
 int FreeRTOS_write(Network* n, unsigned char* buffer, int len, int timeout_ms)
+#endif
 {
     TickType_t xTicksToWait = timeout_ms / portTICK_PERIOD_MS; /* convert milliseconds to ticks */
     TimeOut_t xTimeOut;
@@ -122,7 +126,12 @@ int FreeRTOS_write(Network* n, unsigned char* buffer, int len, int timeout_ms)
         int rc = 0;
 
         FreeRTOS_setsockopt(n->my_socket, 0, FREERTOS_SO_RCVTIMEO, &xTicksToWait, sizeof(xTicksToWait));
+#ifdef MQTT_RAI_OPTIMIZE
+        /* The indication rides on the segment holding the end of the packet */
+        rc = ps_send(n->my_socket, buffer + sentLen, len - sentLen, 0, rai, exceptdata);
+#else
         rc = FreeRTOS_send(n->my_socket, buffer + sentLen, len - sentLen, 0);
+#endif
         if (rc > 0)
             sentLen += rc;
         else if (rc < 0)
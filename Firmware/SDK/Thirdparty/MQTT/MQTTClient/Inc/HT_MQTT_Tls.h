@@ -51,6 +51,46 @@
 #define HT_MQTT_TX_BUF_LEN 1024
 #define HT_MQTT_RX_BUF_LEN 1024
 
+#define HT_MQTT_TLS_ERR_HANDSHAKE (-2)      /**</ TCP is up but the TLS handshake or the peer verification failed. */
+#define HT_MQTT_TLS_PIN_LEN 32              /**</ SHA-256 of the server SubjectPublicKeyInfo. */
+#define HT_MQTT_TLS_RESEED_MS (60*60*1000)  /**</ Age of the DRBG seed that triggers a reseed before a reconnect. */
+
+#ifndef HT_MQTT_TLS_MAX_FRAG_LEN
+#define HT_MQTT_TLS_MAX_FRAG_LEN MBEDTLS_SSL_MAX_FRAG_LEN_1024 /**</ Record size asked of the server, MBEDTLS_SSL_MAX_FRAG_LEN_NONE to skip. */
+#endif
+
+#define HT_MQTT_TLS_PROFILE_STATES (MBEDTLS_SSL_SERVER_HELLO_VERIFY_REQUEST_SENT + 1)
+
+/**
+ * \struct HT_MQTT_TLSStateProfile
+ * \brief Time and traffic spent in one mbedtls_ssl_states handshake state.
+ */
+typedef struct {
+    uint32_t time_ms;
+    uint32_t tx_bytes;
+    uint32_t rx_bytes;
+    uint16_t steps;                         /**</ mbedtls_ssl_handshake_step() calls made in this state. */
+} HT_MQTT_TLSStateProfile;
+
+/**
+ * \struct HT_MQTT_TLSProfile
+ * \brief Profile of the last HT_MQTT_TLSConnect() call, retry included.
+ */
+typedef struct {
+    uint32_t seed_ms;                       /**</ Entropy gathering and CTR-DRBG seeding, 0 when the state was reused. */
+    uint32_t parse_ms;                      /**</ Certificate and key parsing, 0 when the state was reused. */
+    uint32_t tcp_ms;                        /**</ Socket creation and TCP connect. */
+    uint32_t handshake_ms;
+    uint32_t tx_bytes;                      /**</ Handshake bytes written to the socket. */
+    uint32_t rx_bytes;                      /**</ Handshake bytes read from the socket. */
+    uint32_t heap_peak;                     /**</ Highest heap use above the level at connect start, sampled between steps. */
+    uint32_t arena_peak;                    /**</ Highest mbedTLS arena use during the connect, exact. */
+    uint32_t arena_used;                    /**</ mbedTLS arena use once connected: the state kept for the session. */
+    uint8_t attempts;
+    bool setup;                             /**</ The long-lived TLS state was built during this connect. */
+    HT_MQTT_TLSStateProfile state[HT_MQTT_TLS_PROFILE_STATES];
+} HT_MQTT_TLSProfile;
+
 typedef struct MqttClientSslTag {
     mbedtls_ssl_context sslContext;
     mbedtls_net_context netContext;
@@ -61,6 +101,16 @@ typedef struct MqttClientSslTag {
     mbedtls_x509_crt caCert;
     mbedtls_x509_crt clientCert;
     mbedtls_pk_context pkContext;
+    /* Parameters the state above was built from; a change forces a rebuild */
+    const char *caCert_src;
+    const char *clientCert_src;
+    const char *clientPk_src;
+    const unsigned char *psk_src;
+    const unsigned char *pskIdentity_src;
+    int32_t timeout_r;
+    const unsigned char *serverPins;
+    size_t serverPinCount;
+    TickType_t seedTick;                    /**</ Last DRBG seed or reseed. */
 } MqttClientSsl;
 
 typedef struct MqttClientContextTag {
@@ -87,10 +137,97 @@ typedef struct MqttClientContextTag {
     int32_t clientPkLen;
     char *host;
     uint32_t timeout_ms;
+    const unsigned char *session;           /**</ Serialized session to resume (HT_MQTT_TLSSessionSave), NULL for none. */
+    size_t sessionLen;
+    bool sessionResumed;                    /**</ Set by HT_MQTT_TLSConnect when the abbreviated handshake was accepted. */
+    const unsigned char *psk;               /**</ Pre-shared key, NULL for certificate based sessions. */
+    size_t pskLen;
+    const unsigned char *pskIdentity;
+    size_t pskIdentityLen;
+    const unsigned char *serverPins;        /**</ Accepted server key hashes (HT_MQTT_TLS_PIN_LEN each), NULL to verify against caCert. */
+    size_t serverPinCount;
 } MqttClientContext;
 
+/*!******************************************************************
+ * \fn int32_t HT_MQTT_TLSConnect(MqttClientContext *context, Network *network)
+ * \brief Opens the TCP socket and runs the TLS handshake. The TLS
+ * state lives in a single statically allocated MqttClientSsl. Entropy,
+ * DRBG, parsed certificates, configuration and SSL buffers are built on
+ * the first connect of a boot; later connects with the same parameters
+ * only reset the SSL context (mbedtls_ssl_session_reset) and handshake.
+ * Certificates and keys may be PEM or DER; DER certificates are parsed
+ * in place, so their buffer must stay valid while the state is kept.
+ * When context->serverPins is set, the server is accepted only if the
+ * SHA-256 of its public key matches a pin, and caCert is not used.
+ * When context->psk is set, only the PSK cipher suites are offered
+ * (TLS_PSK_WITH_AES_128_CCM_8 first) and no certificate is exchanged.
+ * When context->session is set, an abbreviated handshake resuming that
+ * session (session ID or ticket) is tried first; if the server aborts
+ * it, the connection is retried once with a full handshake.
+ *
+ * \param[in]  context         MQTT TLS connection parameters.
+ * \param[out] network         Network structure bound to the TLS session.
+ *
+ * \retval 0 on success, negative value otherwise.
+ *******************************************************************/
 int32_t HT_MQTT_TLSConnect(MqttClientContext *context, Network *network);
 
+/*!******************************************************************
+ * \fn void HT_MQTT_TLSRelease(bool closeSocket)
+ * \brief Frees every mbedTLS object held by the static TLS context and
+ * resets the mbedTLS arena. The network disconnect callback only closes
+ * the socket; this is needed to drop the state explicitly, e.g. after
+ * new credentials or once the last connection of a wake is closed.
+ *
+ * \param[in]  closeSocket     false leaves the socket open, e.g. after a
+ *                             last packet sent with release assistance.
+ * \param[out] none
+ *
+ * \retval none
+ *******************************************************************/
+void HT_MQTT_TLSRelease(bool closeSocket);
+
+/*!******************************************************************
+ * \fn int32_t HT_MQTT_TLSSessionSave(unsigned char *buf, size_t size, size_t *olen)
+ * \brief Serializes the session of the current TLS connection so it can
+ * be kept across hibernation and passed back in context->session.
+ *
+ * \param[in]  buf             Destination buffer.
+ * \param[in]  size            Size of buf.
+ * \param[out] olen            Serialized length, also set when buf is too small.
+ *
+ * \retval 0 on success, negative mbedTLS error otherwise.
+ *******************************************************************/
+int32_t HT_MQTT_TLSSessionSave(unsigned char *buf, size_t size, size_t *olen);
+
+/*!******************************************************************
+ * \fn unsigned char *HT_MQTT_TLSSendBuffer(size_t *len)
+ * \brief Returns the plaintext area of the TLS output record buffer. An
+ * MQTT client initialized with it as its send buffer serializes packets
+ * straight into the next record: the network write callback encrypts
+ * them in place, with no copy and no separate MQTT send buffer. Valid
+ * from a successful HT_MQTT_TLSConnect() until the next connect or
+ * release. A TLS alert sent meanwhile overwrites a packet being built.
+ *
+ * \param[in]  none
+ * \param[out] len             Largest packet that fits in one record.
+ *
+ * \retval Buffer, NULL when no TLS connection is up.
+ *******************************************************************/
+unsigned char *HT_MQTT_TLSSendBuffer(size_t *len);
+
+/*!******************************************************************
+ * \fn const HT_MQTT_TLSProfile *HT_MQTT_TLSGetProfile(void)
+ * \brief Returns the timing, traffic and heap profile of the last
+ * HT_MQTT_TLSConnect() call, successful or not.
+ *
+ * \param[in]  none
+ * \param[out] none
+ *
+ * \retval Pointer to the static profile.
+ *******************************************************************/
+const HT_MQTT_TLSProfile *HT_MQTT_TLSGetProfile(void);
+
 #endif /*__HT_MQTT_H__*/
 
 /************************ HT Micron Semicondutores S.A *****END OF FILE****/
@@ -39,7 +39,6 @@
 #endif
 
 #include "MQTTPacket.h"
-#include "MQTTFreeRTOS.h"
 
 #if defined(MQTTCLIENT_PLATFORM_HEADER)
 /* The following sequence of macros converts the MQTTCLIENT_PLATFORM_HEADER value
@@ -48,6 +47,8 @@
 #define xstr(s) str(s)
 #define str(s) #s
 #include xstr(MQTTCLIENT_PLATFORM_HEADER)
+#else
+#include "MQTTFreeRTOS.h"
 #endif
 
 #define MAX_PACKET_ID 65535 /* according to the MQTT specification - do not change! */
@@ -56,8 +57,40 @@
 #define MAX_MESSAGE_HANDLERS 5 /* redefinable - how many subscriptions do you want? */
 #endif
 
+#if !defined(MQTT_INBOUND_QUEUE_LEN)
+#define MQTT_INBOUND_QUEUE_LEN 4 /* inbound PUBLISH slots - 0 calls the handlers from cycle() */
+#endif
+
+#if !defined(MQTT_INBOUND_TOPIC_LEN)
+#define MQTT_INBOUND_TOPIC_LEN 64 /* largest topic name a slot holds */
+#endif
+
+#if !defined(MQTT_INBOUND_PAYLOAD_LEN)
+#define MQTT_INBOUND_PAYLOAD_LEN 256 /* largest payload a slot holds, larger ones bypass the queue */
+#endif
+
+#if !defined(MQTT_INBOUND_POLICY)
+#define MQTT_INBOUND_POLICY MQTT_INBOUND_DROP_OLDEST
+#endif
+
 enum QoS { QOS0, QOS1, QOS2, SUBFAIL=0x80 };
 
+/* What cycle() does with a PUBLISH that finds the inbound queue full */
+enum MQTTInboundPolicy
+{
+    MQTT_INBOUND_DROP_OLDEST, /* overwrite the oldest queued message, the new one is acknowledged */
+    MQTT_INBOUND_REJECT       /* discard the new message without PUBACK/PUBREC so the broker redelivers it */
+};
+
+/* Release Assistance Indication sent with a packet, same values as the PS
+ * socket layer's PS_SOCK_RAI_* */
+enum MQTTReleaseAssist
+{
+    MQTT_RAI_NONE = 0,
+    MQTT_RAI_NO_FURTHER_DATA = 1, /* no uplink or downlink follows: release right after sending */
+    MQTT_RAI_ONLY_DL_FOLLOWED = 2 /* release after a single downlink, e.g. the PUBACK of a QoS 1 publish */
+};
+
 /* all failure return codes must be negative */
 enum returnCode { BUFFER_OVERFLOW = -2, FAILURE = -1, SUCCESS = 0 };
 
@@ -107,6 +140,65 @@ typedef struct MQTTSubackData
 
 typedef void (*messageHandler)(MessageData*);
 
+typedef struct MQTTInboundStats
+{
+    unsigned int depth;          /* messages waiting for MQTTInboundDispatch() */
+    unsigned int high_watermark; /* largest depth seen */
+    unsigned int enqueued;
+    unsigned int delivered;
+    unsigned int dropped;        /* overwritten by MQTT_INBOUND_DROP_OLDEST */
+    unsigned int rejected;       /* not acknowledged by MQTT_INBOUND_REJECT */
+    unsigned int oversized;      /* larger than a slot, delivered from cycle() without queueing */
+} MQTTInboundStats;
+
+/* Stages reported to a streamHandler for a PUBLISH larger than the read buffer */
+enum MQTTStreamEvent
+{
+    MQTT_STREAM_BEGIN,  /* topic and message attributes are valid, no payload yet */
+    MQTT_STREAM_CHUNK,  /* chunk/chunk_len hold the payload bytes at offset */
+    MQTT_STREAM_END,    /* the whole payload was delivered */
+    MQTT_STREAM_ABORT   /* the connection failed in the middle of the payload */
+};
+
+typedef struct MQTTStreamData
+{
+    enum MQTTStreamEvent event;
+    MQTTString* topicName;
+    enum QoS qos;
+    unsigned char retained;
+    unsigned char dup;
+    unsigned short id;
+    size_t total_len;        /* payload length announced by the fixed header */
+    size_t offset;           /* payload offset of chunk */
+    unsigned char* chunk;    /* points into the client read buffer, valid during the call only */
+    size_t chunk_len;
+} MQTTStreamData;
+
+/* Returning anything but SUCCESS stops delivery of the message; the rest of the
+ * payload is read and discarded and the PUBLISH is not acknowledged. */
+typedef int (*streamHandler)(MQTTStreamData*);
+
+#if MQTT_INBOUND_QUEUE_LEN > 0
+typedef struct MQTTInboundSlot
+{
+    MQTTMessage message;
+    int topiclen;
+    char topic[MQTT_INBOUND_TOPIC_LEN];
+    unsigned char payload[MQTT_INBOUND_PAYLOAD_LEN];
+} MQTTInboundSlot;
+
+typedef struct MQTTInboundQueue
+{
+    MQTTInboundSlot slots[MQTT_INBOUND_QUEUE_LEN];
+    MQTTInboundSlot current;     /* message being handled, owned by the dispatcher */
+    unsigned int head,
+      count;
+    enum MQTTInboundPolicy policy;
+    MQTTInboundStats stats;
+    Mutex mutex;
+} MQTTInboundQueue;
+#endif
+
 typedef struct MQTTClient
 {
     unsigned int next_packetid,
@@ -127,9 +219,22 @@ typedef struct MQTTClient
     } messageHandlers[MAX_MESSAGE_HANDLERS];      /* Message handlers are indexed by subscription topic */
 
     void (*defaultMessageHandler) (MessageData*);
+    streamHandler streamHandler;
+
+    struct MQTTStreamState
+    {
+        char pending;                /* readPacket() consumed a streamed PUBLISH, cycle() still has to ack it */
+        char ack;
+        enum QoS qos;
+        unsigned short id;
+    } stream;
 
     Network* ipstack;
     Timer last_sent, last_received;
+    unsigned char rai;               /* MQTTReleaseAssist of the next packet sent */
+#if MQTT_INBOUND_QUEUE_LEN > 0
+    MQTTInboundQueue inbound;
+#endif
 #if defined(MQTT_TASK)
     Mutex mutex;
     Thread thread;
@@ -267,6 +372,15 @@ DLLExport int MQTTUnsubscribe(MQTTClient* client, const char* topicFilter);
  */
 DLLExport int MQTTDisconnect(MQTTClient* client);
 
+/** Marks the next packet sent as the last uplink of the connection: the
+ *  transport passes rai to the modem with it so the RRC connection is
+ *  released without waiting for the network inactivity timer. It applies
+ *  to one packet only and is ignored by transports without RAI support.
+ *  @param client - the client object to use
+ *  @param rai - an MQTTReleaseAssist value
+ */
+DLLExport void MQTTSetReleaseAssist(MQTTClient* client, enum MQTTReleaseAssist rai);
+
 /** MQTT Yield - MQTT background
  *  @param client - the client object to use
  *  @param time - the time, in milliseconds, to yield for
@@ -280,6 +394,34 @@ DLLExport int MQTTYield(MQTTClient* client, int time);
  */
 DLLExport int MQTTIsConnected(MQTTClient* client);
 
+/** MQTT Set Stream Handler - receive PUBLISHes larger than the read buffer in chunks.
+ *  Without a stream handler such messages are read, discarded and acknowledged.
+ *  The handler runs on the receive path, so it should only store the data (e.g. to flash).
+ *  @param client - the client object to use
+ *  @param handler - the handler, or NULL to remove it
+ */
+DLLExport void MQTTSetStreamHandler(MQTTClient* client, streamHandler handler);
+
+/** MQTT Inbound Dispatch - run the message handlers for the PUBLISHes queued by cycle().
+ *  Call it from the application task; the receive path only copies messages into the queue.
+ *  @param client - the client object to use
+ *  @param max_messages - upper bound of messages handled in this call, 0 for all
+ *  @return number of messages handled
+ */
+DLLExport int MQTTInboundDispatch(MQTTClient* client, int max_messages);
+
+/** MQTT Inbound Set Policy - choose what happens to a PUBLISH when the inbound queue is full
+ *  @param client - the client object to use
+ *  @param policy - MQTT_INBOUND_DROP_OLDEST or MQTT_INBOUND_REJECT
+ */
+DLLExport void MQTTInboundSetPolicy(MQTTClient* client, enum MQTTInboundPolicy policy);
+
+/** MQTT Inbound Get Stats - read the inbound queue counters
+ *  @param client - the client object to use
+ *  @param stats - filled with the current depth and the counters since the first MQTTClientInit()
+ */
+DLLExport void MQTTInboundGetStats(MQTTClient* client, MQTTInboundStats* stats);
+
 #if defined(MQTT_TASK)
 /** MQTT start background thread for a client.  After this, MQTTYield should not be called.
 *  @param client - the client object to use
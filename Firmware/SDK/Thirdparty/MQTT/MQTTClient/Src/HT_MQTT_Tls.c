@@ -1,40 +1,243 @@
 
 #include "HT_MQTT_Tls.h"
+#include "mbedtls/platform_util.h"
+#include "mbedtls/sha256.h"
+#include "mbedtls/asn1.h"
+#include "mbedtls/ssl_internal.h"
+#include "memory_arena_qcx212.h"
+#include "entropy_hw_qcx212.h"
+#include <string.h>
+
+/* Single TLS session: the network callbacks reach it through ssl, which
+ * is NULL while no mbedTLS state is held. */
+static MqttClientSsl sslStorage;
+MqttClientSsl *ssl = NULL;
+
+/* Master secret of the session offered for resumption: it is reused only
+ * when the server accepted the abbreviated handshake. */
+static unsigned char offeredMaster[48];
+static bool sessionOffered = false;
+
+/* Handshake profile of the last connect, see HT_MQTT_TLSGetProfile() */
+static HT_MQTT_TLSProfile profile;
+static size_t profileHeapStart;
+static bool profileTraffic = false;
+
+#ifdef MQTT_RAI_OPTIMIZE
+/* Release assistance for the record being sent, set by HT_MQTT_TLSWrite() */
+static unsigned char recordRai = MQTT_RAI_NONE;
+#endif
 
-MqttClientSsl *ssl;
+#define HT_MQTT_TLS_ELAPSED_MS(start) ((uint32_t)((xTaskGetTickCount() - (start)) * portTICK_PERIOD_MS))
+
+#if defined(MBEDTLS_KEY_EXCHANGE_PSK_ENABLED)
+/* Plain PSK: no public key operation at all. CCM_8 keeps the record overhead lowest. */
+static const int pskCiphersuites[] = {
+	MBEDTLS_TLS_PSK_WITH_AES_128_CCM_8,
+	MBEDTLS_TLS_PSK_WITH_AES_128_CCM,
+	MBEDTLS_TLS_PSK_WITH_AES_128_GCM_SHA256,
+	MBEDTLS_TLS_PSK_WITH_AES_128_CBC_SHA256,
+	0
+};
+#endif
 
 static int HT_MQTT_MyCertVerify(void * data, mbedtls_x509_crt * crt, int depth, uint32_t * flags) {
-	char buf[4096];
+	MqttClientSsl *tls = (MqttClientSsl *) data;
+	unsigned char hash[HT_MQTT_TLS_PIN_LEN];
+
+	if (tls == NULL || tls->serverPins == NULL)
+		return (0);
+
+	// Pinning replaces the chain check: only the server public key decides
+	if (depth > 0) {
+		*flags = 0;
+		return (0);
+	}
+
+	*flags = MBEDTLS_X509_BADCERT_NOT_TRUSTED;
+	if (mbedtls_sha256_ret(crt->pk_raw.p, crt->pk_raw.len, hash, 0) != 0)
+		return (0);
+
+	for (size_t i = 0; i < tls->serverPinCount; i++) {
+		if (memcmp(hash, tls->serverPins + i * HT_MQTT_TLS_PIN_LEN, HT_MQTT_TLS_PIN_LEN) == 0) {
+			*flags = 0;
+			break;
+		}
+	}
 
-	((void) data);
-	mbedtls_x509_crt_info(buf, sizeof(buf) - 1, "", crt);
 	return (0);
 }
 
+/* DER input, possibly several concatenated certificates, is parsed in place
+ * (the buffer, e.g. XIP flash, must outlive the context); PEM text goes
+ * through the base64 decoder and is copied. */
+static int HT_MQTT_TLSParseCrt(mbedtls_x509_crt *crt, const unsigned char *buf, size_t len) {
+	if (len == 0 || buf[0] != (MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE))
+		return mbedtls_x509_crt_parse(crt, buf, len);
+
+	while (len > 0) {
+		unsigned char *p = (unsigned char *) buf;
+		size_t body;
+		size_t crtLen;
+		int ret;
+
+		if ((ret = mbedtls_asn1_get_tag(&p, buf + len, &body, MBEDTLS_ASN1_CONSTRUCTED | MBEDTLS_ASN1_SEQUENCE)) != 0)
+			return ret;
+
+		crtLen = (size_t) (p - buf) + body;
+		if ((ret = mbedtls_x509_crt_parse_der_nocopy(crt, buf, crtLen)) != 0)
+			return ret;
+
+		buf += crtLen;
+		len -= crtLen;
+	}
+
+	return 0;
+}
+
+/* Socket callbacks counting the traffic for the profile */
+static int HT_MQTT_TLSNetSend(void *ctx, const unsigned char *buf, size_t len) {
+	int ret;
+
+#ifdef MQTT_RAI_OPTIMIZE
+	if (recordRai != MQTT_RAI_NONE) {
+		int fd = ((mbedtls_net_context *) ctx)->fd;
+
+		// Same error mapping as mbedtls_net_send()
+		ret = ps_send(fd, buf, len, 0, recordRai, false);
+		if (ret < 0)
+			ret = (sock_get_errno(fd) == EWOULDBLOCK) ? MBEDTLS_ERR_SSL_WANT_WRITE : MBEDTLS_ERR_NET_SEND_FAILED;
+	} else
+#endif
+	ret = mbedtls_net_send(ctx, buf, len);
+
+	if (ret > 0 && profileTraffic)
+		profile.tx_bytes += ret;
+	return ret;
+}
+
+static int HT_MQTT_TLSNetRecv(void *ctx, unsigned char *buf, size_t len) {
+	int ret = mbedtls_net_recv(ctx, buf, len);
+
+	if (ret > 0 && profileTraffic)
+		profile.rx_bytes += ret;
+	return ret;
+}
+
+static int HT_MQTT_TLSNetRecvTimeout(void *ctx, unsigned char *buf, size_t len, uint32_t timeout) {
+	int ret = mbedtls_net_recv_timeout(ctx, buf, len, timeout);
+
+	if (ret > 0 && profileTraffic)
+		profile.rx_bytes += ret;
+	return ret;
+}
+
+static void HT_MQTT_TLSSampleHeap(void) {
+	size_t free_now = xPortGetFreeHeapSize();
+
+	if (free_now < profileHeapStart && profileHeapStart - free_now > profile.heap_peak)
+		profile.heap_peak = profileHeapStart - free_now;
+}
+
 static int HT_MQTT_TLSDisconnect(Network * network) {
 	int ret = 0;
 
+	if (ssl == NULL)
+		return 0;
+
 	do {
 		ret = mbedtls_ssl_close_notify(&(ssl->sslContext));
 	} while(ret == MBEDTLS_ERR_SSL_WANT_WRITE);
 
-	mbedtls_net_free(&(ssl->netContext));
+	// Only the socket goes away; the configuration, DRBG and certificates serve the next connect
+	mbedtls_net_free(&ssl->netContext);
+	network->my_socket = -1;
 
 	return 0;
 }
 
+void HT_MQTT_TLSRelease(bool closeSocket) {
+	if (ssl == NULL)
+		return;
+
+	// Left open, the socket is only forgotten: no FIN after a packet sent with release assistance
+	if (closeSocket)
+		mbedtls_net_free(&ssl->netContext);
+	else
+		ssl->netContext.fd = -1;
+	mbedtls_ssl_free(&ssl->sslContext);
+	mbedtls_ssl_config_free(&ssl->sslConfig);
+	mbedtls_x509_crt_free(&ssl->caCert);
+	mbedtls_x509_crt_free(&ssl->clientCert);
+	mbedtls_pk_free(&ssl->pkContext);
+	mbedtls_ctr_drbg_free(&ssl->ctrDrbgContext);
+	mbedtls_entropy_free(&ssl->entropyContext);
+
+	mbedtls_platform_zeroize(offeredMaster, sizeof(offeredMaster));
+	sessionOffered = false;
+	ssl = NULL;
+
+	// Nothing of the TLS session is left: the arena goes back to one free block
+	qcx212_arena_reset();
+}
+
+static int HT_MQTT_TLSWriteInPlace(int len) {
+	mbedtls_ssl_context *ctx = &(ssl->sslContext);
+	int ret;
+
+	// The packet already is the record payload: a record still pending would have been overwritten
+	if (ctx->state != MBEDTLS_SSL_HANDSHAKE_OVER || ctx->out_left != 0 ||
+			len > mbedtls_ssl_get_max_out_record_payload(ctx))
+		return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+
+	ctx->out_msgtype = MBEDTLS_SSL_MSG_APPLICATION_DATA;
+	ctx->out_msglen = len;
+
+	// Encrypts in place and flushes; a partial send leaves the rest in out_left
+	ret = mbedtls_ssl_write_record(ctx, 1);
+	while (ret == MBEDTLS_ERR_SSL_WANT_WRITE || ret == MBEDTLS_ERR_SSL_WANT_READ)
+		ret = mbedtls_ssl_flush_output(ctx);
+
+	return (ret == 0) ? len : ret;
+}
+
+#ifdef MQTT_RAI_OPTIMIZE
+static int HT_MQTT_TLSWrite(Network * network, unsigned char *buffer, int len, int timeout_ms, unsigned char rai, bool exceptdata) {
+#else
 static int HT_MQTT_TLSWrite(Network * network, unsigned char *buffer, int len, int timeout_ms) {
+#endif
 	int ret = 0;
 	int written;
 	int frags;
 
+	if (ssl != NULL && buffer == ssl->sslContext.out_msg) {
+#ifdef MQTT_RAI_OPTIMIZE
+		recordRai = rai;
+		ret = HT_MQTT_TLSWriteInPlace(len);
+		recordRai = MQTT_RAI_NONE;
+		return ret;
+#else
+		return HT_MQTT_TLSWriteInPlace(len);
+#endif
+	}
+
 	for (written = 0, frags = 0; written < len; written += ret, frags++) {
+#ifdef MQTT_RAI_OPTIMIZE
+		// Only the record carrying the end of the packet releases the connection
+		recordRai = (len - written <= mbedtls_ssl_get_max_out_record_payload(&(ssl->sslContext))) ? rai : MQTT_RAI_NONE;
+#endif
 		while ((ret = mbedtls_ssl_write(&(ssl->sslContext), buffer + written, len - written)) <= 0) {
 			if (ret != MBEDTLS_ERR_SSL_WANT_READ && ret != MBEDTLS_ERR_SSL_WANT_WRITE) {
+#ifdef MQTT_RAI_OPTIMIZE
+				recordRai = MQTT_RAI_NONE;
+#endif
 				return ret;
 			}
 		}
 	}
+#ifdef MQTT_RAI_OPTIMIZE
+	recordRai = MQTT_RAI_NONE;
+#endif
 
 	return written;
 }
@@ -49,13 +252,14 @@ static int HT_MQTT_TLSRead(Network * network, unsigned char *buffer, int len, in
 		mbedtls_ssl_conf_read_timeout(&(ssl->sslConfig), timeout_ms);
 
 	do {
-		ret_val = mbedtls_ssl_read(&(ssl->sslContext), buffer, len);
+		// A read can span several TLS records, append each one after the previous
+		ret_val = mbedtls_ssl_read(&(ssl->sslContext), buffer + rxLen, len - rxLen);
 
 		if (ret_val > 0) {
 			rxLen += ret_val;
 		}
 		else if (ret_val == MBEDTLS_ERR_SSL_TIMEOUT) {
-			ret_val = 0;
+			ret_val = rxLen;
 			return ret_val;
 		}
 		else if (ret_val == MBEDTLS_ERR_SSL_WANT_READ) {
@@ -72,16 +276,64 @@ static int HT_MQTT_TLSRead(Network * network, unsigned char *buffer, int len, in
 	
 	} while( (!isErrorFlag) && (!isCompleteFlag) );
 
+	if (isCompleteFlag)
+		ret_val = rxLen;
+
 	return ret_val;
 }
 
-int32_t HT_MQTT_TLSConnect(MqttClientContext *context, Network *network) {
+static void HT_MQTT_TLSOfferSession(MqttClientContext *context) {
+	mbedtls_ssl_session session;
+
+	mbedtls_ssl_session_init(&session);
+
+	// A session saved by another mbedTLS build or configuration fails to load: full handshake
+	if (mbedtls_ssl_session_load(&session, context->session, context->sessionLen) == 0 &&
+		mbedtls_ssl_set_session(&(ssl->sslContext), &session) == 0) {
+		memcpy(offeredMaster, session.master, sizeof(offeredMaster));
+		sessionOffered = true;
+	}
+
+	mbedtls_ssl_session_free(&session);
+}
+
+int32_t HT_MQTT_TLSSessionSave(unsigned char *buf, size_t size, size_t *olen) {
+	*olen = 0;
+
+	if (ssl == NULL || ssl->sslContext.state != MBEDTLS_SSL_HANDSHAKE_OVER)
+		return MBEDTLS_ERR_SSL_BAD_INPUT_DATA;
+
+	return mbedtls_ssl_session_save(mbedtls_ssl_get_session_pointer(&(ssl->sslContext)), buf, size, olen);
+}
+
+static bool HT_MQTT_TLSSameSetup(const MqttClientContext *context) {
+	return ssl->caCert_src == context->caCert && ssl->clientCert_src == context->clientCert &&
+		   ssl->clientPk_src == context->clientPk && ssl->psk_src == context->psk &&
+		   ssl->pskIdentity_src == context->pskIdentity && ssl->timeout_r == context->timeout_r &&
+		   ssl->serverPins == context->serverPins && ssl->serverPinCount == context->serverPinCount;
+}
+
+/* Long-lived part of the TLS state: entropy, DRBG, parsed certificates,
+ * configuration and the SSL context buffers. Built once per boot and kept
+ * across reconnects while the connection parameters do not change. */
+static int32_t HT_MQTT_TLSSetup(MqttClientContext *context) {
 	int32_t ret = 0;
 	const char *custom = "SSLs";
     int32_t authmode = MBEDTLS_SSL_VERIFY_NONE;
+	TickType_t start;
 
-	context->ssl = malloc(sizeof(MqttClientSsl));
-    ssl = context->ssl;
+	ssl = &sslStorage;
+#if defined(MBEDTLS_X509_CRT_PARSE_C)
+	ssl->crtProfile = mbedtls_x509_crt_profile_default;
+#endif
+	ssl->caCert_src = context->caCert;
+	ssl->clientCert_src = context->clientCert;
+	ssl->clientPk_src = context->clientPk;
+	ssl->psk_src = context->psk;
+	ssl->pskIdentity_src = context->pskIdentity;
+	ssl->timeout_r = context->timeout_r;
+	ssl->serverPins = context->serverPins;
+	ssl->serverPinCount = (context->serverPins != NULL) ? context->serverPinCount : 0;
 
 	/*
 	 * 0. Initialize the RNG and the session data
@@ -96,18 +348,38 @@ int32_t HT_MQTT_TLSConnect(MqttClientContext *context, Network *network) {
     mbedtls_ctr_drbg_init(&ssl->ctrDrbgContext);
     mbedtls_entropy_init(&ssl->entropyContext);
 
+	// The prebuilt mbedTLS has no MBEDTLS_ENTROPY_HARDWARE_ALT: the TRNG is
+	// added here as the strong source the DRBG seed waits for
+	if ((ret = mbedtls_entropy_add_source(&ssl->entropyContext, qcx212_trng_poll, NULL,
+										  QCX212_TRNG_THRESHOLD, MBEDTLS_ENTROPY_SOURCE_STRONG)) != 0) {
+		return ret;
+	}
+
+	profile.setup = true;
+	start = xTaskGetTickCount();
 	if ((ret =
 		 mbedtls_ctr_drbg_seed(& (ssl->ctrDrbgContext), mbedtls_entropy_func, &(ssl->entropyContext), (const unsigned char *) custom, strlen(custom))) !=0) {			
 		return ret;
 	}
+	profile.seed_ms = HT_MQTT_TLS_ELAPSED_MS(start);
+	ssl->seedTick = xTaskGetTickCount();
+
+	// The DRBG is seeded from the TRNG on every boot, and the device hibernates
+	// between reports: no prediction resistance, only a time based reseed below
+	mbedtls_ctr_drbg_set_prediction_resistance(&ssl->ctrDrbgContext, MBEDTLS_CTR_DRBG_PR_OFF);
+	HT_MQTT_TLSSampleHeap();
 
 	/*
 	 * Initialize server ca root 
 	 */
+	start = xTaskGetTickCount();
 
-	if (context->clientCert != NULL && context->clientPk != NULL) {
+	if (ssl->serverPinCount > 0) {
+		// Pinned server key: no CA to parse, the verify callback checks the key hash
+		authmode = MBEDTLS_SSL_VERIFY_OPTIONAL;
+	} else if (context->caCert != NULL && context->caCertLen > 0) {
 		authmode = MBEDTLS_SSL_VERIFY_REQUIRED;
-		ret = mbedtls_x509_crt_parse(& (ssl->caCert), (const unsigned char *)context->caCert, context->caCertLen);
+		ret = HT_MQTT_TLSParseCrt(& (ssl->caCert), (const unsigned char *)context->caCert, context->caCertLen);
 
 		if (ret < 0) {
 			return -1;
@@ -116,7 +388,7 @@ int32_t HT_MQTT_TLSConnect(MqttClientContext *context, Network *network) {
 
 	//2. START OF CLIENT CERT INIT AND PARSING - device_ec_cert.pem
     if (context->clientCert != NULL && context->clientPk != NULL) {
-        ret = mbedtls_x509_crt_parse(&(ssl->clientCert), (const unsigned char *) context->clientCert, context->clientCertLen);
+        ret = HT_MQTT_TLSParseCrt(&(ssl->clientCert), (const unsigned char *) context->clientCert, context->clientCertLen);
         if (ret != 0) {
             return -1;
         }
@@ -126,24 +398,8 @@ int32_t HT_MQTT_TLSConnect(MqttClientContext *context, Network *network) {
             return -1;
         }
     }
-
-	// 5. Setup the network parameters
-	network->mqttread = HT_MQTT_TLSRead;
-	network->mqttwrite = HT_MQTT_TLSWrite;
-	network->disconnect = HT_MQTT_TLSDisconnect;
-
-	// 4. Start the TLS connection
-	ret = NetworkSetConnTimeout(network, 5000, 5000); 	// Add send_timeout , recieve_timeout in TLSConnectParams 
-    if(ret != 0) {
-        return -1;
-    }
-
-	// Step 4.2: Do NetworkConnect // hostname and port
-	ret = TLSNetworkConnect(network, context->host, context->port, context->timeout_ms);
-    if(ret != 0) {
-        return -1;
-    }
-    ssl->netContext.fd = network->my_socket;
+	profile.parse_ms = HT_MQTT_TLS_ELAPSED_MS(start);
+	HT_MQTT_TLSSampleHeap();
 
 	// step 4.4 Moving to setup SSL structure.
 	if ((ret = mbedtls_ssl_config_defaults(&(ssl->sslConfig), 
@@ -156,11 +412,25 @@ int32_t HT_MQTT_TLSConnect(MqttClientContext *context, Network *network) {
 	mbedtls_ssl_conf_max_version(&ssl->sslConfig, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
     mbedtls_ssl_conf_min_version(&ssl->sslConfig, MBEDTLS_SSL_MAJOR_VERSION_3, MBEDTLS_SSL_MINOR_VERSION_3);
 
-	mbedtls_ssl_conf_verify(&ssl->sslConfig, HT_MQTT_MyCertVerify, NULL);
+	mbedtls_ssl_conf_verify(&ssl->sslConfig, HT_MQTT_MyCertVerify, ssl);
 	mbedtls_ssl_conf_authmode(&(ssl->sslConfig), authmode);
 
+	// Step 4.4.1 Pre-shared key: the key authenticates both ends, no certificate is sent
+	if (context->psk != NULL) {
+#if defined(MBEDTLS_KEY_EXCHANGE_PSK_ENABLED)
+		if ((ret = mbedtls_ssl_conf_psk(&(ssl->sslConfig), context->psk, context->pskLen,
+				context->pskIdentity, context->pskIdentityLen)) != 0) {
+			return -1;
+		}
+		mbedtls_ssl_conf_ciphersuites(&(ssl->sslConfig), pskCiphersuites);
+#else
+		return -1;
+#endif
+	}
+
 #if defined(MBEDTLS_SSL_MAX_FRAGMENT_LENGTH)
-    if ((ret = mbedtls_ssl_conf_max_frag_len(&(ssl->sslConfig), MBEDTLS_SSL_MAX_FRAG_LEN_1024)) != 0) {
+    // Caps the server records; with MBEDTLS_SSL_VARIABLE_BUFFER_LENGTH the buffers shrink to it after the handshake
+    if ((ret = mbedtls_ssl_conf_max_frag_len(&(ssl->sslConfig), HT_MQTT_TLS_MAX_FRAG_LEN)) != 0) {
         return -1;
     }
 #endif
@@ -194,24 +464,153 @@ int32_t HT_MQTT_TLSConnect(MqttClientContext *context, Network *network) {
         return -1;
     }
 
+    mbedtls_ssl_set_bio(&(ssl->sslContext), &(ssl->netContext), HT_MQTT_TLSNetSend, HT_MQTT_TLSNetRecv, HT_MQTT_TLSNetRecvTimeout);
+	HT_MQTT_TLSSampleHeap();
+
+	return 0;
+}
+
+static int32_t HT_MQTT_TLSConnectOnce(MqttClientContext *context, Network *network, bool resume) {
+	int32_t ret = 0;
+	TickType_t start;
+
+	// Parameters changed since the state was built: rebuild it from scratch
+	if (ssl != NULL && !HT_MQTT_TLSSameSetup(context))
+		HT_MQTT_TLSRelease(true);
+
+	if (ssl == NULL) {
+		if ((ret = HT_MQTT_TLSSetup(context)) != 0) {
+			HT_MQTT_TLSRelease(true);
+			return ret;
+		}
+	} else {
+		// Reconnect: only the per-connection state is cleared, a socket left by a failed attempt is closed
+		mbedtls_net_free(&ssl->netContext);
+		if (mbedtls_ssl_session_reset(&(ssl->sslContext)) != 0) {
+			HT_MQTT_TLSRelease(true);
+			return -1;
+		}
+
+		// Awake for a long time: fresh entropy before the next handshake
+		if ((xTaskGetTickCount() - ssl->seedTick) >= pdMS_TO_TICKS(HT_MQTT_TLS_RESEED_MS)) {
+			if (mbedtls_ctr_drbg_reseed(&ssl->ctrDrbgContext, NULL, 0) != 0) {
+				HT_MQTT_TLSRelease(true);
+				return -1;
+			}
+			ssl->seedTick = xTaskGetTickCount();
+		}
+	}
+	context->ssl = ssl;
+
+	// 5. Setup the network parameters
+	network->mqttread = HT_MQTT_TLSRead;
+	network->mqttwrite = HT_MQTT_TLSWrite;
+	network->disconnect = HT_MQTT_TLSDisconnect;
+
+	// 4. Start the TLS connection
+	start = xTaskGetTickCount();
+	ret = NetworkSetConnTimeout(network, 5000, 5000); 	// Add send_timeout , recieve_timeout in TLSConnectParams 
+    if(ret != 0) {
+        return -1;
+    }
+
+	// Step 4.2: Do NetworkConnect // hostname and port
+	ssl->netContext.fd = network->my_socket;
+	ret = TLSNetworkConnect(network, context->host, context->port, context->timeout_ms);
+	profile.tcp_ms += HT_MQTT_TLS_ELAPSED_MS(start);
+    if(ret != 0) {
+        return -1;
+    }
+
 	//	  params->pDestinationURL = hostname;
 	mbedtls_ssl_set_hostname(&(ssl->sslContext), context->host);
-    mbedtls_ssl_set_bio(&(ssl->sslContext), &(ssl->netContext), mbedtls_net_send, mbedtls_net_recv, mbedtls_net_recv_timeout);
+
+	// Step 4.11 Offer the saved session for an abbreviated handshake
+	sessionOffered = false;
+	if (resume)
+		HT_MQTT_TLSOfferSession(context);
 	
-	// Step 4.12 TLS HANDSHAKE process on
-    while ((ret = mbedtls_ssl_handshake(&(ssl->sslContext))) != 0) {
-        if ((ret != MBEDTLS_ERR_SSL_WANT_READ) && (ret != MBEDTLS_ERR_SSL_WANT_WRITE)) {
-            return -1;
+	// Step 4.12 TLS HANDSHAKE process on, one state at a time for the profile
+	profileTraffic = true;
+	while (ssl->sslContext.state != MBEDTLS_SSL_HANDSHAKE_OVER) {
+		int state = ssl->sslContext.state;
+		uint32_t tx = profile.tx_bytes;
+		uint32_t rx = profile.rx_bytes;
+		TickType_t step = xTaskGetTickCount();
+
+		ret = mbedtls_ssl_handshake_step(&(ssl->sslContext));
+
+		if (state >= 0 && state < HT_MQTT_TLS_PROFILE_STATES) {
+			profile.state[state].time_ms += HT_MQTT_TLS_ELAPSED_MS(step);
+			profile.state[state].tx_bytes += profile.tx_bytes - tx;
+			profile.state[state].rx_bytes += profile.rx_bytes - rx;
+			profile.state[state].steps++;
+		}
+		profile.handshake_ms += HT_MQTT_TLS_ELAPSED_MS(step);
+		HT_MQTT_TLSSampleHeap();
+
+        if (ret != 0 && (ret != MBEDTLS_ERR_SSL_WANT_READ) && (ret != MBEDTLS_ERR_SSL_WANT_WRITE)) {
+			profileTraffic = false;
+            return HT_MQTT_TLS_ERR_HANDSHAKE;
         }
     }
+	profileTraffic = false;
 
     /*
      * 4. Verify the server certificate
      */
     ret = mbedtls_ssl_get_verify_result(&(ssl->sslContext));
     if (ret != 0) {
-        return -1;
+        return HT_MQTT_TLS_ERR_HANDSHAKE;
     }
 
+	// A resumed session keeps its master secret, a full handshake derives a new one
+	context->sessionResumed = sessionOffered &&
+		memcmp(ssl->sslContext.session->master, offeredMaster, sizeof(offeredMaster)) == 0;
+
+	return ret;
+}
+
+int32_t HT_MQTT_TLSConnect(MqttClientContext *context, Network *network) {
+	bool resume = (context->session != NULL && context->sessionLen > 0);
+	qcx212_arena_stats arena;
+	int32_t ret;
+
+	context->sessionResumed = false;
+	memset(&profile, 0, sizeof(profile));
+	profileHeapStart = xPortGetFreeHeapSize();
+	qcx212_arena_peak_restart();
+
+	profile.attempts++;
+	ret = HT_MQTT_TLSConnectOnce(context, network, resume);
+
+	// Servers normally answer an unknown session with a full handshake; retry for those that abort instead
+	if (ret == HT_MQTT_TLS_ERR_HANDSHAKE && resume) {
+		profile.attempts++;
+		ret = HT_MQTT_TLSConnectOnce(context, network, false);
+	}
+
+	qcx212_arena_get_stats(&arena);
+	profile.arena_peak = arena.peak;
+	profile.arena_used = arena.used;
+
 	return ret;
 }
+
+unsigned char *HT_MQTT_TLSSendBuffer(size_t *len) {
+	int max;
+
+	*len = 0;
+	if (ssl == NULL || ssl->sslContext.state != MBEDTLS_SSL_HANDSHAKE_OVER)
+		return NULL;
+
+	if ((max = mbedtls_ssl_get_max_out_record_payload(&(ssl->sslContext))) <= 0)
+		return NULL;
+
+	*len = (size_t)max;
+	return ssl->sslContext.out_msg;
+}
+
+const HT_MQTT_TLSProfile *HT_MQTT_TLSGetProfile(void) {
+	return &profile;
+}
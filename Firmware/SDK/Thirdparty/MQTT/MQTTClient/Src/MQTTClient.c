@@ -189,11 +189,8 @@ int mqtt_keepalive_retry_count = 0;
 
 void mqttDefMessageArrived(MessageData* data)
 {
-    char *bufTemp = NULL;
-    bufTemp = malloc(data->message->payloadlen+1);
-    memset(bufTemp, 0, data->message->payloadlen+1);
-    memcpy(bufTemp, data->message->payload, data->message->payloadlen);
-    free(bufTemp);
+    /* Messages without a matching topic filter are dropped in place. */
+    (void)data;
 }
 
 static void NewMessageData(MessageData* md, MQTTString* aTopicName, MQTTMessage* aMessage) {
@@ -214,7 +211,7 @@ static int sendPacket(MQTTClient* c, int length, Timer* timer)
     while (sent < length && !TimerIsExpired(timer))
     {
         #ifdef MQTT_RAI_OPTIMIZE
-        rc = c->ipstack->mqttwrite(c->ipstack, &c->buf[sent], length, TimerLeftMS(timer), 0, false);
+        rc = c->ipstack->mqttwrite(c->ipstack, &c->buf[sent], length, TimerLeftMS(timer), c->rai, false);
         #else
         rc = c->ipstack->mqttwrite(c->ipstack, &c->buf[sent], length, TimerLeftMS(timer));
         #endif
@@ -222,6 +219,7 @@ static int sendPacket(MQTTClient* c, int length, Timer* timer)
             break;
         sent += rc;
     }
+    c->rai = MQTT_RAI_NONE;
     if (sent == length)
     {
         TimerCountdown(&c->last_sent, c->keepAliveInterval); // record the fact that we have successfully sent the packet
@@ -249,12 +247,25 @@ void MQTTClientInit(MQTTClient* c, Network* network, unsigned int command_timeou
     c->cleansession = 0;
     c->ping_outstanding = 0;
     c->defaultMessageHandler = mqttDefMessageArrived;
+    c->stream.pending = 0;
+    c->rai = MQTT_RAI_NONE;
       c->next_packetid = 1;
     TimerInit(&c->last_sent);
     TimerInit(&c->last_received);
 #if defined(MQTT_TASK)
       MutexInit(&c->mutex);
 #endif
+#if MQTT_INBOUND_QUEUE_LEN > 0
+    /* Messages still queued from a previous connection survive the re-init */
+    if (c->inbound.mutex.sem == NULL)
+    {
+        MutexInit(&c->inbound.mutex);
+        c->inbound.head = 0;
+        c->inbound.count = 0;
+        c->inbound.policy = MQTT_INBOUND_POLICY;
+        memset(&c->inbound.stats, 0, sizeof(c->inbound.stats));
+    }
+#endif
 }
 
 static int decodePacket(MQTTClient* c, int* value, int timeout)
@@ -284,6 +295,129 @@ exit:
     return len;
 }
 
+static int readStreamedPublish(MQTTClient* c, MQTTHeader header, int len, int rem_len)
+{
+    MQTTStreamData sd;
+    MQTTString topicName = MQTTString_initializer;
+    unsigned char* ptr = c->readbuf + len;
+    unsigned char* chunk = ptr;
+    int chunk_size;
+    int hdr_len;
+    int remaining = rem_len;
+    int deliver = (c->streamHandler != NULL);
+    int rc = FAILURE;
+    Timer timer;
+
+    TimerInit(&timer);
+    TimerCountdownMS(&timer, c->command_timeout_ms);
+
+    memset(&sd, 0, sizeof(sd));
+    sd.qos = (enum QoS)header.bits.qos;
+    sd.retained = header.bits.retain;
+    sd.dup = header.bits.dup;
+
+    /* variable header: topic name and, for QoS > 0, the packet identifier */
+    if (rem_len < 2 || c->ipstack->mqttread(c->ipstack, ptr, 2, TimerLeftMS(&timer)) != 2)
+        goto exit;
+    topicName.lenstring.len = (ptr[0] << 8) | ptr[1];
+    hdr_len = 2 + topicName.lenstring.len + ((sd.qos > QOS0) ? 2 : 0);
+    remaining -= 2;
+
+    if (hdr_len <= rem_len && len + hdr_len < c->readbuf_size)
+    {
+        if (c->ipstack->mqttread(c->ipstack, ptr + 2, hdr_len - 2, TimerLeftMS(&timer)) != hdr_len - 2)
+            goto exit;
+        topicName.lenstring.data = (char*)ptr + 2;
+        if (sd.qos > QOS0)
+            sd.id = (ptr[hdr_len - 2] << 8) | ptr[hdr_len - 1];
+        remaining = rem_len - hdr_len;
+        chunk = ptr + hdr_len;
+    }
+    else
+    {
+        /* not even the topic fits: drain it, but keep the packet identifier so the ack names the right message */
+        int skip = topicName.lenstring.len;
+
+        if (hdr_len > rem_len)
+            goto exit;
+        chunk_size = (int)(c->readbuf + c->readbuf_size - ptr);
+        while (skip > 0)
+        {
+            int n = (skip < chunk_size) ? skip : chunk_size;
+
+            TimerCountdownMS(&timer, c->command_timeout_ms);
+            if (c->ipstack->mqttread(c->ipstack, ptr, n, TimerLeftMS(&timer)) != n)
+                goto exit;
+            skip -= n;
+        }
+        if (sd.qos > QOS0)
+        {
+            if (c->ipstack->mqttread(c->ipstack, ptr, 2, TimerLeftMS(&timer)) != 2)
+                goto exit;
+            sd.id = (ptr[0] << 8) | ptr[1];
+        }
+        remaining = rem_len - hdr_len;
+        deliver = 0;
+    }
+
+    chunk_size = (int)(c->readbuf + c->readbuf_size - chunk);
+    sd.topicName = &topicName;
+    sd.total_len = remaining;
+
+    c->stream.ack = 1;
+    if (deliver)
+    {
+        sd.event = MQTT_STREAM_BEGIN;
+        if (c->streamHandler(&sd) != SUCCESS)
+            deliver = c->stream.ack = 0;
+    }
+
+    while (remaining > 0)
+    {
+        int n = (remaining < chunk_size) ? remaining : chunk_size;
+
+        TimerCountdownMS(&timer, c->command_timeout_ms);
+        if (c->ipstack->mqttread(c->ipstack, chunk, n, TimerLeftMS(&timer)) != n)
+        {
+            if (deliver)
+            {
+                sd.event = MQTT_STREAM_ABORT;
+                sd.chunk = NULL;
+                sd.chunk_len = 0;
+                c->streamHandler(&sd);
+            }
+            goto exit; /* the rest of the packet is still on the socket, the connection is unusable */
+        }
+
+        if (deliver)
+        {
+            sd.event = MQTT_STREAM_CHUNK;
+            sd.chunk = chunk;
+            sd.chunk_len = n;
+            if (c->streamHandler(&sd) != SUCCESS)
+                deliver = c->stream.ack = 0;
+        }
+        sd.offset += n;
+        remaining -= n;
+    }
+
+    if (deliver)
+    {
+        sd.event = MQTT_STREAM_END;
+        sd.chunk = NULL;
+        sd.chunk_len = 0;
+        if (c->streamHandler(&sd) != SUCCESS)
+            c->stream.ack = 0;
+    }
+
+    c->stream.pending = 1;
+    c->stream.qos = sd.qos;
+    c->stream.id = sd.id;
+    rc = PUBLISH;
+exit:
+    return rc;
+}
+
 static int readPacket(MQTTClient* c, Timer* timer)
 {
     MQTTHeader header = {0};
@@ -302,12 +436,14 @@ static int readPacket(MQTTClient* c, Timer* timer)
 
     if (rem_len > (c->readbuf_size - len))
     {
-        rc = BUFFER_OVERFLOW;
-        goto exit;
+        header.byte = c->readbuf[0];
+        /* only a PUBLISH can legitimately be this large: its payload is streamed through the read buffer */
+        rc = (header.bits.type == PUBLISH) ? readStreamedPublish(c, header, len, rem_len) : BUFFER_OVERFLOW;
+        if (rc != PUBLISH)
+            goto exit;
     }
-
     /* 3. read the rest of the buffer using a callback to supply the rest of the data */
-    if (rem_len > 0 && (c->ipstack->mqttread(c->ipstack, c->readbuf + len, rem_len, TimerLeftMS(timer)) != rem_len)) {
+    else if (rem_len > 0 && (c->ipstack->mqttread(c->ipstack, c->readbuf + len, rem_len, TimerLeftMS(timer)) != rem_len)) {
         rc = 0;
         goto exit;
     }
@@ -382,6 +518,115 @@ int deliverMessage(MQTTClient* c, MQTTString* topicName, MQTTMessage* message)
     return rc;
 }
 
+#if MQTT_INBOUND_QUEUE_LEN > 0
+static int inboundEnqueue(MQTTClient* c, MQTTString* topicName, MQTTMessage* message)
+{
+    MQTTInboundQueue* q = &c->inbound;
+    MQTTInboundSlot* slot;
+    int rc = SUCCESS;
+
+    MutexLock(&q->mutex);
+
+    if (topicName->lenstring.len > MQTT_INBOUND_TOPIC_LEN || message->payloadlen > MQTT_INBOUND_PAYLOAD_LEN)
+    {
+        q->stats.oversized++; /* no slot can hold it: the caller delivers it directly */
+        rc = BUFFER_OVERFLOW;
+        goto exit;
+    }
+
+    if (q->count == MQTT_INBOUND_QUEUE_LEN)
+    {
+        if (q->policy == MQTT_INBOUND_REJECT)
+        {
+            q->stats.rejected++;
+            rc = FAILURE;
+            goto exit;
+        }
+        q->head = (q->head + 1) % MQTT_INBOUND_QUEUE_LEN;
+        q->count--;
+        q->stats.dropped++;
+    }
+
+    slot = &q->slots[(q->head + q->count) % MQTT_INBOUND_QUEUE_LEN];
+    slot->message = *message;
+    slot->message.payload = slot->payload;
+    memcpy(slot->payload, message->payload, message->payloadlen);
+    slot->topiclen = topicName->lenstring.len;
+    memcpy(slot->topic, topicName->lenstring.data, topicName->lenstring.len);
+
+    q->count++;
+    q->stats.enqueued++;
+    if (q->count > q->stats.high_watermark)
+        q->stats.high_watermark = q->count;
+
+exit:
+    MutexUnlock(&q->mutex);
+    return rc;
+}
+#endif
+
+void MQTTSetStreamHandler(MQTTClient* c, streamHandler handler)
+{
+    c->streamHandler = handler;
+}
+
+int MQTTInboundDispatch(MQTTClient* c, int max_messages)
+{
+    int delivered = 0;
+#if MQTT_INBOUND_QUEUE_LEN > 0
+    MQTTInboundQueue* q = &c->inbound;
+
+    if (q->mutex.sem == NULL)
+        return 0;
+
+    while (max_messages <= 0 || delivered < max_messages)
+    {
+        MQTTString topicName = MQTTString_initializer;
+
+        MutexLock(&q->mutex);
+        if (q->count == 0)
+        {
+            MutexUnlock(&q->mutex);
+            break;
+        }
+        /* copy out so the receive path can keep queueing while the handler runs */
+        q->current = q->slots[q->head];
+        q->current.message.payload = q->current.payload;
+        q->head = (q->head + 1) % MQTT_INBOUND_QUEUE_LEN;
+        q->count--;
+        q->stats.delivered++;
+        MutexUnlock(&q->mutex);
+
+        topicName.lenstring.len = q->current.topiclen;
+        topicName.lenstring.data = q->current.topic;
+        deliverMessage(c, &topicName, &q->current.message);
+        delivered++;
+    }
+#endif
+    return delivered;
+}
+
+void MQTTInboundSetPolicy(MQTTClient* c, enum MQTTInboundPolicy policy)
+{
+#if MQTT_INBOUND_QUEUE_LEN > 0
+    c->inbound.policy = policy;
+#endif
+}
+
+void MQTTInboundGetStats(MQTTClient* c, MQTTInboundStats* stats)
+{
+    memset(stats, 0, sizeof(*stats));
+#if MQTT_INBOUND_QUEUE_LEN > 0
+    if (c->inbound.mutex.sem == NULL)
+        return;
+
+    MutexLock(&c->inbound.mutex);
+    *stats = c->inbound.stats;
+    stats->depth = c->inbound.count;
+    MutexUnlock(&c->inbound.mutex);
+#endif
+}
+
 // int keepalive(MQTTClient* c)
 // {
 //     int rc = SUCCESS;
@@ -527,11 +772,31 @@ int cycle(MQTTClient* c, Timer* timer)
             MQTTMessage msg;
             int intQoS;
             msg.payloadlen = 0; /* this is a size_t, but deserialize publish sets this as int */
-            if (MQTTDeserialize_publish(&msg.dup, &intQoS, &msg.retained, &msg.id, &topicName,
-               (unsigned char**)&msg.payload, (int*)&msg.payloadlen, c->readbuf, c->readbuf_size) != 1)
-                goto exit;
-            msg.qos = (enum QoS)intQoS;
-            deliverMessage(c, &topicName, &msg);
+            if (c->stream.pending)
+            {
+                /* the payload already went to the stream handler, only the ack is left */
+                c->stream.pending = 0;
+                msg.qos = c->stream.qos;
+                msg.id = c->stream.id;
+                if (!c->stream.ack)
+                    break;
+            }
+            else
+            {
+                if (MQTTDeserialize_publish(&msg.dup, &intQoS, &msg.retained, &msg.id, &topicName,
+                   (unsigned char**)&msg.payload, (int*)&msg.payloadlen, c->readbuf, c->readbuf_size) != 1)
+                    goto exit;
+                msg.qos = (enum QoS)intQoS;
+#if MQTT_INBOUND_QUEUE_LEN > 0
+                int qrc = inboundEnqueue(c, &topicName, &msg);
+                if (qrc == BUFFER_OVERFLOW)
+                    deliverMessage(c, &topicName, &msg); /* fits readbuf but not a slot: handled here, as without the queue */
+                else if (qrc != SUCCESS)
+                    break; /* queue full under MQTT_INBOUND_REJECT: no ack, the broker sends it again */
+#else
+                deliverMessage(c, &topicName, &msg);
+#endif
+            }
             if (msg.qos != QOS0)
             {
                 if (msg.qos == QOS1) {
@@ -697,12 +962,23 @@ int MQTTStartTask(MQTTClient* client)
 
 int MQTTStartRECVTask(MQTTClient* c)
 {
+    static StaticTask_t mqttRecvTaskCb;
+    static uint8_t mqttRecvTaskStack[MQTT_DEMO_TASK_STACK_SIZE];
     osThreadAttr_t task_attr;
 
+    /* MQTTRun never returns, so the task started on the first connection keeps serving the client. */
+    if(mqttRecvTaskHandle != NULL)
+    {
+        return SUCCESS;
+    }
+
     memset(&task_attr, 0, sizeof(task_attr));
     task_attr.name = "mqttRecv";
+    task_attr.stack_mem = mqttRecvTaskStack;
     task_attr.stack_size = MQTT_DEMO_TASK_STACK_SIZE;
     task_attr.priority = osPriorityBelowNormal7;
+    task_attr.cb_mem = &mqttRecvTaskCb;
+    task_attr.cb_size = sizeof(StaticTask_t);
 
     mqttRecvTaskHandle = osThreadNew(MQTTRun, (void *)c, &task_attr);
     if(mqttRecvTaskHandle == NULL)
@@ -1062,6 +1338,11 @@ int MQTTDisconnect(MQTTClient* c)
     return rc;
 }
 
+void MQTTSetReleaseAssist(MQTTClient* c, enum MQTTReleaseAssist rai)
+{
+    c->rai = rai;
+}
+
 int MQTTInit(MQTTClient* c, Network* n, unsigned char* sendBuf, unsigned char* readBuf)
 {
     NetworkInit(n);
@@ -1073,9 +1354,6 @@ int MQTTInit(MQTTClient* c, Network* n, unsigned char* sendBuf, unsigned char* r
 int MQTTCreate(MQTTClient* c, Network* n, char* clientID, char* username, char* password, char *serverAddr, int port, MQTTPacket_connectData* connData)
 {
     MQTTPacket_connectData connectData = MQTTPacket_connectData_initializer;
-    int clientLen = 0;
-    int usernameLen = 0;
-    int passwordLen = 0;
 
     if(connData != NULL)
     {
@@ -1087,28 +1365,21 @@ int MQTTCreate(MQTTClient* c, Network* n, char* clientID, char* username, char*
         connectData.keepAliveInterval = 120;
     }
 
+    /* The strings are only read while MQTTConnect() serializes the packet,
+     * so the caller's buffers are used as they are. */
     if(clientID != NULL)
     {
-        clientLen = strlen(clientID);
-        connectData.clientID.cstring = malloc(clientLen+1);
-        memset(connectData.clientID.cstring, 0, (clientLen+1));
-        memcpy(connectData.clientID.cstring, clientID, clientLen);
+        connectData.clientID.cstring = clientID;
     }
 
     if(username != NULL)
     {
-        usernameLen = strlen(username);
-        connectData.username.cstring = malloc(usernameLen+1);;
-        memset(connectData.username.cstring, 0, (usernameLen+1));
-        memcpy(connectData.username.cstring, username, usernameLen);
+        connectData.username.cstring = username;
     }
 
     if(password != NULL)
     {
-        passwordLen = strlen(password);
-        connectData.password.cstring = malloc(passwordLen+1);
-        memset(connectData.password.cstring, 0, (passwordLen+1));
-        memcpy(connectData.password.cstring, password, passwordLen);
+        connectData.password.cstring = password;
     }
 
     if((NetworkSetConnTimeout(n, 5000, 5000)) != 0)
@@ -0,0 +1,97 @@
+/*******************************************************************************
+ * Copyright (c) 2014, 2015 IBM Corp.
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Allan Stockdill-Mander - initial API and implementation and/or initial documentation
+ *    POSIX port of MQTTFreeRTOS for host builds (HostBench)
+ *******************************************************************************/
+
+#if !defined(MQTTPosix_H)
+#define MQTTPosix_H
+
+#include <sys/time.h>
+#include <pthread.h>
+
+/* Same result codes as MQTTFreeRTOS.h so callers build unchanged on both ports. */
+typedef enum {
+    MQTT_CONN_OK = 0,        ///<Success
+    MQTT_PROCESSING,    ///<Processing
+    MQTT_PARSE,         ///<url Parse error
+    MQTT_DNS,           ///<Could not resolve name
+    MQTT_PRTCL,         ///<Protocol error
+    MQTT_NOTFOUND,      ///<HTTP 404 Error
+    MQTT_REFUSED,       ///<HTTP 403 Error
+    MQTT_ERROR,         ///<HTTP xxx error
+    MQTT_TIMEOUT,       ///<Connection timeout
+    MQTT_CONN,          ///<Connection error
+    MQTT_FATAL_ERROR, //fatal error when conenct
+    MQTT_CLOSED,        ///<Connection was closed by remote host
+    MQTT_MOREDATA,      ///<Need get more data
+    MQTT_OVERFLOW,      ///<Buffer overflow
+    MQTT_MBEDTLS_ERR,
+
+}MQTTResult;
+
+typedef struct Timer
+{
+	struct timeval end_time;
+} Timer;
+
+typedef struct Network Network;
+
+struct Network
+{
+	int my_socket;
+	int (*mqttread) (Network*, unsigned char*, int, int);
+	int (*mqttwrite) (Network*, unsigned char*, int, int);
+	int (*disconnect) (Network*);
+	unsigned long bytes_sent;      /* payload bytes written to the socket since NetworkInit */
+	unsigned long bytes_received;  /* payload bytes read from the socket since NetworkInit */
+};
+
+void TimerInit(Timer*);
+char TimerIsExpired(Timer*);
+void TimerCountdownMS(Timer*, unsigned int);
+void TimerCountdown(Timer*, unsigned int);
+int TimerLeftMS(Timer*);
+
+typedef struct Mutex
+{
+	pthread_mutex_t* sem;  /* NULL until MutexInit(), like the FreeRTOS SemaphoreHandle_t */
+	pthread_mutex_t mtx;
+} Mutex;
+
+void MutexInit(Mutex*);
+int MutexLock(Mutex*);
+int MutexUnlock(Mutex*);
+
+typedef struct Thread
+{
+	pthread_t task;
+} Thread;
+
+int ThreadStart(Thread*, void (*fn)(void*), void* arg);
+
+int Posix_read(Network*, unsigned char*, int, int);
+int Posix_write(Network*, unsigned char*, int, int);
+int Posix_disconnect(Network*);
+
+/* lwIP provides this on target; MQTTClient.c uses it to classify keepalive failures. */
+int sock_get_errno(int sock);
+
+void NetworkInit(Network*);
+int NetworkConnect(Network*, char*, int);
+int NetworkSetConnTimeout(Network* n, int send_timeout, int recv_timeout);
+
+int TLSNetworkConnect(Network* n, char* addr, int port, int timeout_ms);
+
+#endif
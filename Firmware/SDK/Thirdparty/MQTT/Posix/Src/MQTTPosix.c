@@ -0,0 +1,329 @@
+/*******************************************************************************
+ * Copyright (c) 2014, 2015 IBM Corp.
+ *
+ * All rights reserved. This program and the accompanying materials
+ * are made available under the terms of the Eclipse Public License v1.0
+ * and Eclipse Distribution License v1.0 which accompany this distribution.
+ *
+ * The Eclipse Public License is available at
+ *    http://www.eclipse.org/legal/epl-v10.html
+ * and the Eclipse Distribution License is available at
+ *   http://www.eclipse.org/org/documents/edl-v10.php.
+ *
+ * Contributors:
+ *    Allan Stockdill-Mander - initial API and implementation and/or initial documentation
+ *    Ian Craggs - convert to FreeRTOS
+ *    POSIX port of MQTTFreeRTOS for host builds (HostBench)
+ *******************************************************************************/
+
+#include "MQTTPosix.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <netdb.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/select.h>
+#include <sys/socket.h>
+
+#define POSIX_CONNECT_TIMEOUT_MS  30000  /* same as NetworkConnect() on target */
+
+typedef struct {
+    void (*fn)(void*);
+    void* arg;
+} PosixThreadArgs;
+
+static PosixThreadArgs threadArgs;
+
+static void* PosixThreadEntry(void* arg)
+{
+    PosixThreadArgs* args = (PosixThreadArgs*)arg;
+
+    args->fn(args->arg);
+    return NULL;
+}
+
+int ThreadStart(Thread* thread, void (*fn)(void*), void* arg)
+{
+    threadArgs.fn = fn;
+    threadArgs.arg = arg;
+
+    /* Mirror xTaskCreate(): non zero on success. */
+    return pthread_create(&thread->task, NULL, PosixThreadEntry, &threadArgs) == 0;
+}
+
+
+void MutexInit(Mutex* mutex)
+{
+    pthread_mutex_init(&mutex->mtx, NULL);
+    mutex->sem = &mutex->mtx;
+}
+
+int MutexLock(Mutex* mutex)
+{
+    return pthread_mutex_lock(&mutex->mtx) == 0;
+}
+
+int MutexUnlock(Mutex* mutex)
+{
+    return pthread_mutex_unlock(&mutex->mtx) == 0;
+}
+
+
+void TimerCountdownMS(Timer* timer, unsigned int timeout_ms)
+{
+    struct timeval now;
+    struct timeval interval = {timeout_ms / 1000, (timeout_ms % 1000) * 1000};
+
+    gettimeofday(&now, NULL);
+    timeradd(&now, &interval, &timer->end_time);
+}
+
+
+void TimerCountdown(Timer* timer, unsigned int timeout)
+{
+    TimerCountdownMS(timer, timeout * 1000);
+}
+
+
+int TimerLeftMS(Timer* timer)
+{
+    struct timeval now, res;
+
+    gettimeofday(&now, NULL);
+    timersub(&timer->end_time, &now, &res);
+    return (res.tv_sec < 0) ? 0 : (int)(res.tv_sec * 1000 + res.tv_usec / 1000);
+}
+
+
+char TimerIsExpired(Timer* timer)
+{
+    struct timeval now, res;
+
+    gettimeofday(&now, NULL);
+    timersub(&timer->end_time, &now, &res);
+    return res.tv_sec < 0 || (res.tv_sec == 0 && res.tv_usec <= 0);
+}
+
+
+void TimerInit(Timer* timer)
+{
+    timer->end_time = (struct timeval){0, 0};
+}
+
+
+static void PosixSetRecvTimeout(int sock, int timeout_ms)
+{
+    struct timeval tv;
+
+    /* A zero SO_RCVTIMEO means "block forever", the opposite of what a zero timeout asks for. */
+    if (timeout_ms <= 0)
+        timeout_ms = 1;
+
+    tv.tv_sec = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+    setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+}
+
+
+int Posix_read(Network* n, unsigned char* buffer, int len, int timeout_ms)
+{
+    Timer timer;
+    int recvLen = 0;
+
+    TimerCountdownMS(&timer, (unsigned int)timeout_ms);
+    do
+    {
+        int rc = 0;
+
+        PosixSetRecvTimeout(n->my_socket, TimerLeftMS(&timer));
+        rc = recv(n->my_socket, buffer + recvLen, len - recvLen, 0);
+        if (rc > 0)
+            recvLen += rc;
+        else if (rc == 0)
+        {
+            /* orderly shutdown by the peer: report it as an error instead of a timeout */
+            recvLen = -1;
+            break;
+        }
+        else if (errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        {
+            recvLen = rc;
+            break;
+        }
+    } while (recvLen < len && !TimerIsExpired(&timer));
+
+    if (recvLen > 0)
+        n->bytes_received += recvLen;
+
+    return recvLen;
+}
+
+
+int Posix_write(Network* n, unsigned char* buffer, int len, int timeout_ms)
+{
+    Timer timer;
+    int sentLen = 0;
+
+    TimerCountdownMS(&timer, (unsigned int)timeout_ms);
+    do
+    {
+        int rc = 0;
+        struct timeval tv;
+        int left = TimerLeftMS(&timer);
+
+        if (left <= 0)
+            left = 1;
+        tv.tv_sec = left / 1000;
+        tv.tv_usec = (left % 1000) * 1000;
+        setsockopt(n->my_socket, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+        rc = send(n->my_socket, buffer + sentLen, len - sentLen, MSG_NOSIGNAL);
+        if (rc > 0)
+            sentLen += rc;
+        else if (rc < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != EINTR)
+        {
+            sentLen = rc;
+            break;
+        }
+    } while (sentLen < len && !TimerIsExpired(&timer));
+
+    if (sentLen > 0)
+        n->bytes_sent += sentLen;
+
+    return sentLen;
+}
+
+
+int Posix_disconnect(Network* n)
+{
+    int ret = 0;
+
+    if (n->my_socket >= 0)
+    {
+        ret = close(n->my_socket);
+        n->my_socket = -1;
+    }
+    return ret;
+}
+
+
+int sock_get_errno(int sock)
+{
+    int err = 0;
+    socklen_t len = sizeof(err);
+
+    if (getsockopt(sock, SOL_SOCKET, SO_ERROR, &err, &len) != 0)
+        return errno;
+    return err;
+}
+
+
+static int PosixConnectTimeout(int connectFd, int timeout_ms)
+{
+    fd_set writeSet;
+    fd_set errorSet;
+    struct timeval tv;
+
+    FD_ZERO(&writeSet);
+    FD_ZERO(&errorSet);
+    FD_SET(connectFd, &writeSet);
+    FD_SET(connectFd, &errorSet);
+    tv.tv_sec  = timeout_ms / 1000;
+    tv.tv_usec = (timeout_ms % 1000) * 1000;
+
+    if (select(connectFd + 1, NULL, &writeSet, &errorSet, &tv) <= 0)
+        return sock_get_errno(connectFd) ? MQTT_CONN : MQTT_TIMEOUT;
+
+    /* Non blocking connect completion is reported as writable, failures through SO_ERROR. */
+    if (sock_get_errno(connectFd))
+        return MQTT_CONN;
+
+    return MQTT_CONN_OK;
+}
+
+
+void NetworkInit(Network* n)
+{
+    n->my_socket = -1;
+    n->mqttread = Posix_read;
+    n->mqttwrite = Posix_write;
+    n->disconnect = Posix_disconnect;
+    n->bytes_sent = 0;
+    n->bytes_received = 0;
+}
+
+
+int TLSNetworkConnect(Network* n, char* addr, int port, int timeout_ms)
+{
+    struct addrinfo hints;
+    struct addrinfo *result = NULL;
+    struct sockaddr_in sAddr;
+    int retVal = -1;
+    int flags;
+    int one = 1;
+
+    memset(&hints, 0, sizeof(hints));
+    hints.ai_family = AF_INET;
+    hints.ai_socktype = SOCK_STREAM;
+
+    if (getaddrinfo(addr, NULL, &hints, &result) != 0 || result == NULL)
+        goto exit;
+
+    memcpy(&sAddr, result->ai_addr, sizeof(sAddr));
+    sAddr.sin_port = htons((uint16_t)port);
+    freeaddrinfo(result);
+
+    flags = fcntl(n->my_socket, F_GETFL, 0);
+
+    if ((retVal = connect(n->my_socket, (struct sockaddr *)&sAddr, sizeof(sAddr))) < 0)
+    {
+        if (errno == EINPROGRESS)
+            retVal = PosixConnectTimeout(n->my_socket, timeout_ms);
+        else
+            retVal = 1;
+    }
+
+    /* The target stack sends small MQTT packets immediately as well. */
+    setsockopt(n->my_socket, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+    fcntl(n->my_socket, F_SETFL, flags & ~O_NONBLOCK);
+
+exit:
+    return retVal;
+}
+
+
+int NetworkConnect(Network* n, char* addr, int port)
+{
+    return TLSNetworkConnect(n, addr, port, POSIX_CONNECT_TIMEOUT_MS);
+}
+
+
+int NetworkSetConnTimeout(Network* n, int send_timeout, int recv_timeout)
+{
+    struct timeval tx_timeout;
+    struct timeval rx_timeout;
+    int flags;
+
+    tx_timeout.tv_sec = send_timeout / 1000;
+    tx_timeout.tv_usec = (send_timeout % 1000) * 1000;
+    rx_timeout.tv_sec = recv_timeout / 1000;
+    rx_timeout.tv_usec = (recv_timeout % 1000) * 1000;
+
+    if ((n->my_socket = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP)) < 0)
+        return 1;
+
+    setsockopt(n->my_socket, SOL_SOCKET, SO_SNDTIMEO, &tx_timeout, sizeof(tx_timeout));
+    setsockopt(n->my_socket, SOL_SOCKET, SO_RCVTIMEO, &rx_timeout, sizeof(rx_timeout));
+
+    flags = fcntl(n->my_socket, F_GETFL, 0);
+    if (flags < 0)
+        return 1;
+
+    fcntl(n->my_socket, F_SETFL, flags | O_NONBLOCK); //set socket as nonblock for connect timeout
+
+    return 0;
+}